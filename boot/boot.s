@@ -1,6 +1,8 @@
 .section .text.boot
 .global _start
 
+# a0 = hart id and a1 = device tree blob from the boot loader; both are
+# passed through untouched to kernel_main
 _start:
     la sp, stack_top
     
@@ -1,4 +1,5 @@
 #include "console.h"
+#include "../../lib/printf.h"
 
 // QEMU RISC-V UART base address
 #define UART_BASE 0x10000000
@@ -50,19 +51,37 @@ void console_println(const char* str) {
     console_putchar('\n');
 }
 
-void console_put_hex(unsigned int value) {
-    console_puts("0x");
-    // print each hex digit, starting from most significant
-    for (int i = 28; i >= 0; i -= 4) {
-        unsigned int digit = (value >> i) & 0xF;
-        if (digit < 10) {
-            console_putchar('0' + digit);
-        } else {
-            console_putchar('A' + digit - 10);
-        }
+void console_write(const char* buf, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        console_putchar(buf[i]);
     }
 }
 
+// 8 digits unless the value needs all 16
+void console_put_hex(unsigned long value) {
+    console_printf((value >> 32) ? "0x%016lX" : "0x%08lX", value);
+}
+
+static void console_flush(printf_sink_t* sink) {
+    console_write(sink->buf, sink->len);
+    sink->len = 0;
+}
+
+// formatted on the stack and written out in one go; only output longer
+// than the buffer is written in pieces
+int console_printf(const char* fmt, ...) {
+    char buf[CONSOLE_PRINTF_BUFFER];
+    printf_sink_t sink = { buf, sizeof(buf), 0, 0, console_flush };
+
+    va_list args;
+    va_start(args, fmt);
+    int total = kvformat(&sink, fmt, args);
+    va_end(args);
+
+    console_flush(&sink);
+    return total;
+}
+
 // INPUT FUNCTIONS
 char console_getchar(void) {
     // wait until data is available - pure polling, no WFI
@@ -1,6 +1,10 @@
 #ifndef CONSOLE_H
 #define CONSOLE_H
 
+#include <stddef.h>
+
+#define CONSOLE_PRINTF_BUFFER 128
+
 // initialize the console (UART)
 void console_init(void);
 
@@ -15,7 +19,14 @@ void console_puts(const char* str);
 void console_println(const char* str);
 
 // output a hexadecimal number (for debugging)
-void console_put_hex(unsigned int value);
+void console_put_hex(unsigned long value);
+
+// output len bytes of buf
+void console_write(const char* buf, size_t len);
+
+// formatted output (see lib/printf.h for the conversions), sent to the
+// UART as one write; returns the number of characters
+int console_printf(const char* fmt, ...) __attribute__((format(printf, 1, 2)));
 
 // INPUT FUNCTIONS
 // read a single character (blocking)
@@ -35,6 +46,4 @@ void console_clear_line(void);
 
 void console_putc(char c);
 
-void console_putc(char c);
-
 #endif
@@ -0,0 +1,147 @@
+#include "fdt.h"
+#include "../../lib/string.h"
+
+// structure block tokens
+#define FDT_BEGIN_NODE 1
+#define FDT_END_NODE   2
+#define FDT_PROP       3
+#define FDT_NOP        4
+#define FDT_END        9
+
+typedef struct {
+    uint32_t magic;
+    uint32_t totalsize;
+    uint32_t off_dt_struct;
+    uint32_t off_dt_strings;
+    uint32_t off_mem_rsvmap;
+    uint32_t version;
+    uint32_t last_comp_version;
+    uint32_t boot_cpuid_phys;
+    uint32_t size_dt_strings;
+    uint32_t size_dt_struct;
+} fdt_header_t;
+
+// the blob is big endian
+static uint32_t fdt32(const void* p) {
+    const uint8_t* b = (const uint8_t*)p;
+    return ((uint32_t)b[0] << 24) | ((uint32_t)b[1] << 16) |
+           ((uint32_t)b[2] << 8) | (uint32_t)b[3];
+}
+
+static inline uint32_t fdt_align(uint32_t offset) {
+    return (offset + 3) & ~3U;
+}
+
+int fdt_valid(const void* fdt) {
+    if (!fdt || ((uintptr_t)fdt & 3)) {
+        return 0;
+    }
+    
+    const fdt_header_t* header = (const fdt_header_t*)fdt;
+    return fdt32(&header->magic) == FDT_MAGIC &&
+           fdt32(&header->off_dt_struct) < fdt32(&header->totalsize) &&
+           fdt32(&header->off_dt_strings) < fdt32(&header->totalsize);
+}
+
+const void* fdt_find_property(const void* fdt, const char* node_prefix,
+                              const char* name, uint32_t* len) {
+    if (!fdt_valid(fdt)) {
+        return NULL;
+    }
+    
+    const fdt_header_t* header = (const fdt_header_t*)fdt;
+    const char* base = (const char*)fdt;
+    const char* strings = base + fdt32(&header->off_dt_strings);
+    uint32_t offset = fdt32(&header->off_dt_struct);
+    uint32_t end = offset + fdt32(&header->size_dt_struct);
+    size_t prefix_len = strlen(node_prefix);
+    
+    // depth of the innermost node matching node_prefix, 0 if outside one
+    int depth = 0;
+    int match_depth = 0;
+    
+    while (offset + 4 <= end) {
+        uint32_t token = fdt32(base + offset);
+        offset += 4;
+        
+        switch (token) {
+            case FDT_BEGIN_NODE: {
+                const char* node_name = base + offset;
+                depth++;
+                if (!match_depth && strncmp(node_name, node_prefix, prefix_len) == 0) {
+                    match_depth = depth;
+                }
+                offset = fdt_align(offset + strlen(node_name) + 1);
+                break;
+            }
+            case FDT_END_NODE:
+                if (match_depth == depth) {
+                    match_depth = 0;
+                }
+                depth--;
+                break;
+            case FDT_PROP: {
+                uint32_t value_len = fdt32(base + offset);
+                uint32_t name_offset = fdt32(base + offset + 4);
+                const char* value = base + offset + 8;
+                if (match_depth == depth && strcmp(strings + name_offset, name) == 0) {
+                    if (len) {
+                        *len = value_len;
+                    }
+                    return value;
+                }
+                offset = fdt_align(offset + 8 + value_len);
+                break;
+            }
+            case FDT_NOP:
+                break;
+            default:   // FDT_END or garbage
+                return NULL;
+        }
+    }
+    
+    return NULL;
+}
+
+int fdt_cpu_has_extension(const void* fdt, const char* ext) {
+    uint32_t len;
+    size_t ext_len = strlen(ext);
+    
+    // newer bindings: a string list of lower-case extension names
+    const char* list = fdt_find_property(fdt, "cpu@", "riscv,isa-extensions", &len);
+    if (list) {
+        for (const char* entry = list; entry < list + len; entry += strlen(entry) + 1) {
+            if (strcmp(entry, ext) == 0) {
+                return 1;
+            }
+        }
+        return 0;
+    }
+    
+    // riscv,isa: "rv64imafdc_zicsr_zbb..." with multi-letter extensions
+    // separated by underscores
+    const char* isa = fdt_find_property(fdt, "cpu@", "riscv,isa", &len);
+    if (!isa) {
+        return 0;
+    }
+    for (const char* p = strchr(isa, '_'); p; p = strchr(p + 1, '_')) {
+        if (strncmp(p + 1, ext, ext_len) == 0 && (p[1 + ext_len] == '_' || p[1 + ext_len] == '\0')) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+uint64_t fdt_timebase_frequency(const void* fdt) {
+    uint32_t len;
+    const char* value = fdt_find_property(fdt, "cpus", "timebase-frequency", &len);
+    if (!value) {
+        return 0;
+    }
+    
+    // one cell normally, two on some boards
+    if (len == 8) {
+        return ((uint64_t)fdt32(value) << 32) | fdt32(value + 4);
+    }
+    return (len == 4) ? fdt32(value) : 0;
+}
@@ -0,0 +1,26 @@
+#ifndef FDT_H
+#define FDT_H
+
+#include "../include/types.h"
+
+#define FDT_MAGIC 0xd00dfeed
+
+// flattened device tree handed over by the boot loader in a1; all lookups
+// fail cleanly on a NULL or corrupt blob
+
+// returns 1 if the blob starts with a valid header
+int fdt_valid(const void* fdt);
+
+// value of the first property called name in a node whose name starts with
+// node_prefix (e.g. "cpu@"); stores its length in len if not NULL
+const void* fdt_find_property(const void* fdt, const char* node_prefix,
+                              const char* name, uint32_t* len);
+
+// 1 if the first CPU node lists the ISA extension ext (e.g. "zbb") in
+// riscv,isa-extensions or as a multi-letter part of riscv,isa
+int fdt_cpu_has_extension(const void* fdt, const char* ext);
+
+// /cpus timebase-frequency in Hz (the rate of mtime), 0 if not present
+uint64_t fdt_timebase_frequency(const void* fdt);
+
+#endif
@@ -0,0 +1,27 @@
+#include "timer.h"
+#include "fdt.h"
+
+// QEMU virt CLINT; mtime is a 64-bit counter
+#define CLINT_MTIME 0x0200BFF8UL
+#define TIMER_DEFAULT_FREQUENCY 10000000UL
+
+static uint64_t frequency = TIMER_DEFAULT_FREQUENCY;
+
+void timer_init(const void* dtb) {
+    uint64_t timebase = fdt_timebase_frequency(dtb);
+    if (timebase) {
+        frequency = timebase;
+    }
+}
+
+uint64_t timer_ticks(void) {
+    return *(volatile uint64_t*)CLINT_MTIME;
+}
+
+uint64_t timer_frequency(void) {
+    return frequency;
+}
+
+uint64_t timer_ticks_to_us(uint64_t ticks) {
+    return ticks * 1000000 / frequency;
+}
@@ -0,0 +1,18 @@
+#ifndef TIMER_H
+#define TIMER_H
+
+#include "../include/types.h"
+
+// free-running machine timer (CLINT mtime) for measuring elapsed time
+
+// reads the tick rate from the device tree, falling back to QEMU virt's
+// 10 MHz
+void timer_init(const void* dtb);
+
+uint64_t timer_ticks(void);
+uint64_t timer_frequency(void);
+
+// ticks converted to microseconds
+uint64_t timer_ticks_to_us(uint64_t ticks);
+
+#endif
@@ -2,59 +2,18 @@
 #include "../drivers/console.h"
 #include "../fs/fs.h"
 #include "../../lib/string.h"
+#include "../memory/scratch.h"
+#include "keywords_gen.h"
 
 // global editor state
 static editor_state_t editor;
 
-// C keywords
-static const char* c_keywords[] = {
-    "auto", "break", "case", "char", "const", "continue", "default", "do",
-    "double", "else", "enum", "extern", "float", "for", "goto", "if",
-    "inline", "int", "long", "register", "restrict", "return", "short",
-    "signed", "sizeof", "static", "struct", "switch", "typedef", "union",
-    "unsigned", "void", "volatile", "while", "_Bool", "_Complex", "_Imaginary",
-    "include", "define", "ifdef", "ifndef", "endif", "pragma", NULL
-};
-
-// verilog keywords
-static const char* verilog_keywords[] = {
-    "always", "and", "assign", "begin", "buf", "bufif0", "bufif1", "case",
-    "casex", "casez", "cmos", "deassign", "default", "defparam", "disable",
-    "edge", "else", "end", "endcase", "endfunction", "endmodule", "endprimitive",
-    "endspecify", "endtable", "endtask", "event", "for", "force", "forever",
-    "fork", "function", "highz0", "highz1", "if", "ifnone", "initial", "inout",
-    "input", "integer", "join", "large", "macromodule", "medium", "module",
-    "nand", "negedge", "nmos", "nor", "not", "notif0", "notif1", "or", "output",
-    "parameter", "pmos", "posedge", "primitive", "pull0", "pull1", "pulldown",
-    "pullup", "rcmos", "real", "realtime", "reg", "release", "repeat", "rnmos",
-    "rpmos", "rtran", "rtranif0", "rtranif1", "scalared", "small", "specify",
-    "specparam", "strong0", "strong1", "supply0", "supply1", "table", "task",
-    "time", "tran", "tranif0", "tranif1", "tri", "tri0", "tri1", "triand",
-    "trior", "trireg", "vectored", "wait", "wand", "weak0", "weak1", "while",
-    "wire", "wor", "xnor", "xor", "logic", "bit", "byte", NULL
-};
-
-// RISC-V instructions
-static const char* riscv_instructions[] = {
-    "add", "addi", "sub", "lui", "auipc", "xor", "xori", "or", "ori", "and", "andi",
-    "sll", "slli", "srl", "srli", "sra", "srai", "slt", "slti", "sltu", "sltiu",
-    "beq", "bne", "blt", "bge", "bltu", "bgeu", "jal", "jalr", "lb", "lh", "lw",
-    "lbu", "lhu", "sb", "sh", "sw", "fence", "fence.i", "ecall", "ebreak",
-    "csrrw", "csrrs", "csrrc", "csrrwi", "csrrsi", "csrrci", "mul", "mulh",
-    "mulhsu", "mulhu", "div", "divu", "rem", "remu", "lr.w", "sc.w", "amoswap.w",
-    "amoadd.w", "amoxor.w", "amoand.w", "amoor.w", "amomin.w", "amomax.w",
-    "amominu.w", "amomaxu.w", NULL
-};
-
-// RISC-V registers
-static const char* riscv_registers[] = {
-    "x0", "x1", "x2", "x3", "x4", "x5", "x6", "x7", "x8", "x9", "x10", "x11",
-    "x12", "x13", "x14", "x15", "x16", "x17", "x18", "x19", "x20", "x21", "x22",
-    "x23", "x24", "x25", "x26", "x27", "x28", "x29", "x30", "x31",
-    "zero", "ra", "sp", "gp", "tp", "t0", "t1", "t2", "s0", "s1", "a0", "a1",
-    "a2", "a3", "a4", "a5", "a6", "a7", "s2", "s3", "s4", "s5", "s6", "s7",
-    "s8", "s9", "s10", "s11", "t3", "t4", "t5", "t6", "fp", NULL
-};
+// keyword lookups go through the perfect-hash tables generated from
+// keywords/*.txt; the shell's highlighter uses the same functions
+static bool keyword_table_has(const keyword_table_t* table, const char* word) {
+    unsigned char slot = table->slots[keyword_hash(word, table->seed) & table->mask];
+    return slot != 0 && strcmp(table->words[slot - 1], word) == 0;
+}
 
 // console utility function
 void console_put_dec(unsigned int value) {
@@ -122,39 +81,23 @@ language_t detect_language(const char* filename) {
 }
 
 bool is_c_keyword(const char* word) {
-    for (int i = 0; c_keywords[i] != NULL; i++) {
-        if (strcmp(word, c_keywords[i]) == 0) {
-            return true;
-        }
-    }
-    return false;
+    return keyword_table_has(&keywords_c, word);
 }
 
 bool is_verilog_keyword(const char* word) {
-    for (int i = 0; verilog_keywords[i] != NULL; i++) {
-        if (strcmp(word, verilog_keywords[i]) == 0) {
-            return true;
-        }
-    }
-    return false;
+    return keyword_table_has(&keywords_verilog, word);
 }
 
 bool is_riscv_instruction(const char* word) {
-    for (int i = 0; riscv_instructions[i] != NULL; i++) {
-        if (strcmp(word, riscv_instructions[i]) == 0) {
-            return true;
-        }
-    }
-    return false;
+    return keyword_table_has(&keywords_riscv_instructions, word);
 }
 
 bool is_riscv_register(const char* word) {
-    for (int i = 0; riscv_registers[i] != NULL; i++) {
-        if (strcmp(word, riscv_registers[i]) == 0) {
-            return true;
-        }
-    }
-    return false;
+    return keyword_table_has(&keywords_riscv_registers, word);
+}
+
+bool is_asm_keyword(const char* word) {
+    return keyword_table_has(&keywords_asm, word);
 }
 
 bool is_alpha(char c) {
@@ -435,13 +378,20 @@ void editor_show_status(void) {
 }
 
 int editor_load_file(const char* filename) {
-    char buffer[4096];
-    int bytes_read = fs_read_file(filename, buffer, sizeof(buffer) - 1);
+    size_t mark = scratch_mark();
+    char* buffer = scratch_alloc(MAX_FILE_SIZE);
+    if (!buffer) {
+        console_puts("Out of scratch memory.\n");
+        return -1;
+    }
+    
+    int bytes_read = fs_read_file(filename, buffer, MAX_FILE_SIZE - 1);
     
     if (bytes_read < 0) {
         // new file
         editor.line_count = 1;
         editor.lines[0][0] = '\0';
+        scratch_release(mark);
         return 0;
     }
     
@@ -466,16 +416,22 @@ int editor_load_file(const char* filename) {
         editor.lines[0][0] = '\0';
     }
     
+    scratch_release(mark);
     return 0;
 }
 
 int editor_save_file(void) {
-    char buffer[4096];
+    size_t mark = scratch_mark();
+    char* buffer = scratch_alloc(MAX_FILE_SIZE);
+    if (!buffer) {
+        console_puts("Out of scratch memory.\n");
+        return -1;
+    }
     int pos = 0;
     
-    for (int i = 0; i < editor.line_count && pos < sizeof(buffer) - 1; i++) {
+    for (int i = 0; i < editor.line_count && pos < MAX_FILE_SIZE - 1; i++) {
         int line_len = strlen(editor.lines[i]);
-        if (pos + line_len + 1 < sizeof(buffer)) {
+        if (pos + line_len + 1 < MAX_FILE_SIZE) {
             strcpy(buffer + pos, editor.lines[i]);
             pos += line_len;
             if (i < editor.line_count - 1) {
@@ -486,6 +442,7 @@ int editor_save_file(void) {
     buffer[pos] = '\0';
     
     int result = fs_write_file(editor.filename, buffer, pos);
+    scratch_release(mark);
     if (result == FS_SUCCESS) {
         editor.modified = false;
         console_puts("File saved successfully.\n");
@@ -613,9 +570,10 @@ int editor_start(const char* filename) {
     
      char choice = '1';
      
-    // check if file exists and handle accordingly
-    char buffer[4096];
-    int bytes_read = fs_read_file(filename, buffer, sizeof(buffer) - 1);
+    // check if file exists and handle accordingly (a zero-byte read only
+    // probes for the file)
+    char probe;
+    int bytes_read = fs_read_file(filename, &probe, 0);
     
     if (bytes_read >= 0) {
         // file exists - ask user what to do
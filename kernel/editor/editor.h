@@ -48,6 +48,7 @@ bool is_c_keyword(const char* word);
 bool is_verilog_keyword(const char* word);
 bool is_riscv_instruction(const char* word);
 bool is_riscv_register(const char* word);
+bool is_asm_keyword(const char* word);
 bool is_alpha(char c);
 bool is_digit(char c);
 bool is_alnum(char c);
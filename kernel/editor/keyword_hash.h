@@ -0,0 +1,26 @@
+#ifndef KEYWORD_HASH_H
+#define KEYWORD_HASH_H
+
+// perfect-hash keyword tables generated at build time by tools/gen_keywords
+// from kernel/editor/keywords/*.txt (see build/keywords_gen.h). Each table's
+// seed is chosen so no two of its words share a slot, so a lookup is one
+// hash and one compare. Slots are bytes because a single-hash perfect table
+// needs room to spare. Shared with the host generator, so no kernel headers.
+
+typedef struct {
+    const char* const* words;
+    const unsigned char* slots; // word index + 1, 0 for an unused slot
+    unsigned int seed;
+    unsigned int mask;          // slot count - 1
+} keyword_table_t;
+
+// seeded FNV-1a with a final fold so the low bits see the whole word
+static inline unsigned int keyword_hash(const char* word, unsigned int seed) {
+    unsigned int hash = 2166136261u ^ seed;
+    while (*word) {
+        hash = (hash ^ (unsigned char)*word++) * 16777619u;
+    }
+    return hash ^ (hash >> 15);
+}
+
+#endif
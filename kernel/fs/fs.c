@@ -1,9 +1,25 @@
 #include "fs.h"
 #include "../drivers/console.h"
 #include "../../lib/string.h"
+#include "../../lib/hash.h"
+#include "../memory/scratch.h"
+#include "../memory/slab.h"
 
 filesystem_t fs;
 static uint32_t system_time = 0;
+static kmem_cache_t* node_cache = NULL;
+
+static void index_insert(uint32_t id);
+
+// entries live in a slab cache; an id is the entry's slot in fs.files
+static file_entry_t* new_entry(uint32_t id) {
+    file_entry_t* entry = kmem_cache_alloc(node_cache);
+    if (entry) {
+        memset(entry, 0, sizeof(file_entry_t));
+        fs.files[id] = entry;
+    }
+    return entry;
+}
 
 int fs_init(void) {
     // clear the entire filesystem structure
@@ -11,16 +27,29 @@ int fs_init(void) {
     
     console_puts("[DEBUG] Initializing filesystem...\n");
     
+    if (!node_cache) {
+        node_cache = kmem_cache_create("fs_node", sizeof(file_entry_t), NULL);
+    }
+    if (!new_entry(0)) {
+        console_puts("[DEBUG] No memory for the root directory\n");
+        return FS_ERROR_NO_SPACE;
+    }
+    
     // initialize root directory (ID 0)
-    fs.files[0].name[0] = '/';
-    fs.files[0].name[1] = '\0';
-    fs.files[0].type = FILE_TYPE_DIRECTORY;
-    fs.files[0].size = 0;
-    fs.files[0].permissions = PERM_READ | PERM_WRITE | PERM_EXEC;
-    fs.files[0].parent_id = 0;  
-    fs.files[0].created_time = system_time++;
-    fs.files[0].modified_time = system_time;
-    fs.files[0].data_offset = 0;
+    fs.files[0]->name[0] = '/';
+    fs.files[0]->name[1] = '\0';
+    fs.files[0]->type = FILE_TYPE_DIRECTORY;
+    fs.files[0]->size = 0;
+    fs.files[0]->permissions = PERM_READ | PERM_WRITE | PERM_EXEC;
+    fs.files[0]->parent_id = 0;  
+    fs.files[0]->created_time = system_time++;
+    fs.files[0]->modified_time = system_time;
+    fs.files[0]->data_offset = 0;
+    fs.files[0]->first_child = FS_NO_ENTRY;
+    fs.files[0]->last_child = FS_NO_ENTRY;
+    fs.files[0]->next_sibling = FS_NO_ENTRY;
+    fs.files[0]->prev_sibling = FS_NO_ENTRY;
+    index_insert(0);
     
     // initialize filesystem metadata
     fs.file_count = 1;          // start with 1 (root directory)
@@ -38,85 +67,193 @@ int fs_init(void) {
     console_puts("[DEBUG] Creating initial directories...\n");
     
     int result = fs_make_directory("home");
-    console_puts("[DEBUG] fs_make_directory(\"home\") result: ");
-    char buf[16];
-    itoa(result, buf, 10);
-    console_puts(buf);
-    console_puts(", file_count now: ");
-    itoa(fs.file_count, buf, 10);
-    console_puts(buf);
-    console_puts("\n");
+    console_printf("[DEBUG] fs_make_directory(\"home\") result: %d, file_count now: %u\n",
+                   result, fs.file_count);
     
     result = fs_make_directory("bin");
-    console_puts("[DEBUG] fs_make_directory(\"bin\") result: ");
-    itoa(result, buf, 10);
-    console_puts(buf);
-    console_puts(", file_count now: ");
-    itoa(fs.file_count, buf, 10);
-    console_puts(buf);
-    console_puts("\n");
+    console_printf("[DEBUG] fs_make_directory(\"bin\") result: %d, file_count now: %u\n",
+                   result, fs.file_count);
     
     result = fs_make_directory("etc");
-    console_puts("[DEBUG] fs_make_directory(\"etc\") result: ");
-    itoa(result, buf, 10);
-    console_puts(buf);
-    console_puts(", file_count now: ");
-    itoa(fs.file_count, buf, 10);
-    console_puts(buf);
-    console_puts("\n");
+    console_printf("[DEBUG] fs_make_directory(\"etc\") result: %d, file_count now: %u\n",
+                   result, fs.file_count);
     
-    console_puts("[DEBUG] fs_init completed. Final file_count: ");
-    itoa(fs.file_count, buf, 10);
-    console_puts(buf);
-    console_puts(", next_file_id: ");
-    itoa(fs.next_file_id, buf, 10);
-    console_puts(buf);
-    console_puts("\n");
+    console_printf("[DEBUG] fs_init completed. Final file_count: %u, next_file_id: %u\n",
+                   fs.file_count, fs.next_file_id);
     
     // DEBUG: show what directories were actually created
     console_puts("[DEBUG] Directory table after init:\n");
     for (uint32_t i = 0; i < fs.file_count; i++) {
-        console_puts("[DEBUG] ID ");
-        itoa(i, buf, 10);
-        console_puts(buf);
-        console_puts(": name='");
-        console_puts(fs.files[i].name);
-        console_puts("', parent=");
-        itoa(fs.files[i].parent_id, buf, 10);
-        console_puts(buf);
-        console_puts(", type=");
-        console_puts((fs.files[i].type == FILE_TYPE_DIRECTORY) ? "DIR" : "FILE");
-        console_puts("\n");
+        console_printf("[DEBUG] ID %u: name='%s', parent=%u, type=%s\n",
+                       i, fs.files[i]->name, fs.files[i]->parent_id,
+                       (fs.files[i]->type == FILE_TYPE_DIRECTORY) ? "DIR" : "FILE");
     }
     
     return FS_SUCCESS;
 }
 
-static int find_file_in_dir(uint32_t dir_id, const char* name) {
-    for (uint32_t i = 0; i < fs.file_count; i++) {
-        if (fs.files[i].parent_id == dir_id && strcmp(fs.files[i].name, name) == 0) {
-            return i;
+static uint32_t name_hash(const char* name, size_t length) {
+    return (uint32_t)xxh64(name, length, 0);
+}
+
+static uint32_t index_home(uint32_t parent_id, uint32_t hash) {
+    uint32_t key = hash ^ (parent_id * 0x9E3779B9U);
+    key ^= key >> 16;
+    return key & (FS_INDEX_SIZE - 1);
+}
+
+static uint32_t index_next(uint32_t slot) {
+    return (slot + 1) & (FS_INDEX_SIZE - 1);
+}
+
+// the slot holding id; the entry must be indexed under its current key
+static uint32_t index_slot_of(uint32_t id) {
+    uint32_t slot = index_home(fs.files[id]->parent_id, fs.files[id]->name_hash);
+    while (fs.index[slot] != id + 1) {
+        slot = index_next(slot);
+    }
+    return slot;
+}
+
+// call once name and parent_id are set
+static void index_insert(uint32_t id) {
+    file_entry_t* entry = fs.files[id];
+    entry->name_hash = name_hash(entry->name, strlen(entry->name));
+
+    uint32_t slot = index_home(entry->parent_id, entry->name_hash);
+    while (fs.index[slot]) {
+        slot = index_next(slot);
+    }
+    fs.index[slot] = id + 1;
+}
+
+// linear probing without tombstones: later entries of the run move back
+// into the hole unless that would put them before their home slot
+static void index_remove(uint32_t id) {
+    uint32_t hole = index_slot_of(id);
+    for (uint32_t slot = index_next(hole); fs.index[slot]; slot = index_next(slot)) {
+        file_entry_t* entry = fs.files[fs.index[slot] - 1];
+        uint32_t home = index_home(entry->parent_id, entry->name_hash);
+        if (((slot - home) & (FS_INDEX_SIZE - 1)) >= ((slot - hole) & (FS_INDEX_SIZE - 1))) {
+            fs.index[hole] = fs.index[slot];
+            hole = slot;
+        }
+    }
+    fs.index[hole] = 0;
+}
+
+// name is a span so path components can be looked up in place
+static int find_span_in_dir(uint32_t dir_id, str_span_t name) {
+    uint32_t hash = name_hash(name.start, name.length);
+    for (uint32_t slot = index_home(dir_id, hash); fs.index[slot]; slot = index_next(slot)) {
+        uint32_t id = fs.index[slot] - 1;
+        file_entry_t* entry = fs.files[id];
+        if (entry->name_hash == hash && entry->parent_id == dir_id && str_span_equals(name, entry->name)) {
+            return id;
         }
     }
     return -1;
 }
 
+static int find_file_in_dir(uint32_t dir_id, const char* name) {
+    str_span_t span = { name, strlen(name) };
+    return find_span_in_dir(dir_id, span);
+}
+
+// indexes a new entry and appends it to its parent's children
+static void add_entry(uint32_t id) {
+    file_entry_t* entry = fs.files[id];
+    file_entry_t* parent = fs.files[entry->parent_id];
+
+    entry->first_child = FS_NO_ENTRY;
+    entry->last_child = FS_NO_ENTRY;
+    entry->next_sibling = FS_NO_ENTRY;
+    entry->prev_sibling = parent->last_child;
+    if (parent->last_child != FS_NO_ENTRY) {
+        fs.files[parent->last_child]->next_sibling = id;
+    } else {
+        parent->first_child = id;
+    }
+    parent->last_child = id;
+
+    index_insert(id);
+}
+
+static void unlink_entry(uint32_t id) {
+    file_entry_t* entry = fs.files[id];
+    file_entry_t* parent = fs.files[entry->parent_id];
+
+    if (entry->prev_sibling != FS_NO_ENTRY) {
+        fs.files[entry->prev_sibling]->next_sibling = entry->next_sibling;
+    } else {
+        parent->first_child = entry->next_sibling;
+    }
+    if (entry->next_sibling != FS_NO_ENTRY) {
+        fs.files[entry->next_sibling]->prev_sibling = entry->prev_sibling;
+    } else {
+        parent->last_child = entry->prev_sibling;
+    }
+}
+
+// the table stays dense: the last entry moves into the freed slot, and
+// whatever pointed at its old id is updated. Directories must be empty.
+static void remove_entry(uint32_t id) {
+    uint32_t last = fs.file_count - 1;
+    file_entry_t* removed = fs.files[id];
+    index_remove(id);
+    unlink_entry(id);
+
+    if (id < last) {
+        // the index reads entries while it probes, so move the entry first
+        fs.index[index_slot_of(last)] = id + 1;
+        fs.files[id] = fs.files[last];
+
+        file_entry_t* moved = fs.files[id];
+        if (moved->prev_sibling != FS_NO_ENTRY) {
+            fs.files[moved->prev_sibling]->next_sibling = id;
+        } else {
+            fs.files[moved->parent_id]->first_child = id;
+        }
+        if (moved->next_sibling != FS_NO_ENTRY) {
+            fs.files[moved->next_sibling]->prev_sibling = id;
+        } else {
+            fs.files[moved->parent_id]->last_child = id;
+        }
+
+        for (uint32_t child = moved->first_child; child != FS_NO_ENTRY;
+             child = fs.files[child]->next_sibling) {
+            index_remove(child);
+            fs.files[child]->parent_id = id;
+            index_insert(child);
+        }
+        if (fs.current_dir == last) {
+            fs.current_dir = id;
+        }
+    }
+
+    fs.files[last] = NULL;
+    kmem_cache_free(node_cache, removed);
+    fs.file_count--;
+}
+
 int fs_create_file(const char* name, file_type_t type) {
     if (fs.file_count >= MAX_FILES) return FS_ERROR_NO_SPACE;
     if (find_file_in_dir(fs.current_dir, name) >= 0) return FS_ERROR_ALREADY_EXISTS;
 
     uint32_t new_index = fs.file_count;
-    strncpy(fs.files[new_index].name, name, MAX_FILENAME - 1);
-    fs.files[new_index].name[MAX_FILENAME - 1] = '\0';
-    fs.files[new_index].type = type;
-    fs.files[new_index].size = 0;
-    fs.files[new_index].permissions = (type == FILE_TYPE_DIRECTORY)
+    if (!new_entry(new_index)) return FS_ERROR_NO_SPACE;
+    strncpy(fs.files[new_index]->name, name, MAX_FILENAME - 1);
+    fs.files[new_index]->name[MAX_FILENAME - 1] = '\0';
+    fs.files[new_index]->type = type;
+    fs.files[new_index]->size = 0;
+    fs.files[new_index]->permissions = (type == FILE_TYPE_DIRECTORY)
         ? (PERM_READ | PERM_WRITE | PERM_EXEC)
         : (PERM_READ | PERM_WRITE);
-    fs.files[new_index].parent_id = fs.current_dir;
-    fs.files[new_index].created_time = system_time++;
-    fs.files[new_index].modified_time = system_time;
-    fs.files[new_index].data_offset = fs.data_usage;
+    fs.files[new_index]->parent_id = fs.current_dir;
+    fs.files[new_index]->created_time = system_time++;
+    fs.files[new_index]->modified_time = system_time;
+    fs.files[new_index]->data_offset = fs.data_usage;
+    add_entry(new_index);
 
     fs.file_count++;
     return FS_SUCCESS;
@@ -129,15 +266,15 @@ int fs_write_file(const char* name, const void* data, uint32_t size) {
         file_id = find_file_in_dir(fs.current_dir, name);
     }
 
-    if (fs.files[file_id].type != FILE_TYPE_REGULAR) return FS_ERROR_INVALID_PATH;
+    if (fs.files[file_id]->type != FILE_TYPE_REGULAR) return FS_ERROR_INVALID_PATH;
     if (size > MAX_FILE_SIZE) size = MAX_FILE_SIZE;
 
-    memcpy(&fs.data_storage[fs.files[file_id].data_offset], data, size);
-    fs.files[file_id].size = size;
-    fs.files[file_id].modified_time = system_time++;
+    memcpy(&fs.data_storage[fs.files[file_id]->data_offset], data, size);
+    fs.files[file_id]->size = size;
+    fs.files[file_id]->modified_time = system_time++;
 
-    if (fs.files[file_id].data_offset + size > fs.data_usage) {
-        fs.data_usage = fs.files[file_id].data_offset + size;
+    if (fs.files[file_id]->data_offset + size > fs.data_usage) {
+        fs.data_usage = fs.files[file_id]->data_offset + size;
     }
 
     return FS_SUCCESS;
@@ -145,15 +282,15 @@ int fs_write_file(const char* name, const void* data, uint32_t size) {
 
 int fs_read_file(const char* name, void* buffer, uint32_t size) {
     int file_id = find_file_in_dir(fs.current_dir, name);
-    if (file_id < 0 || fs.files[file_id].type != FILE_TYPE_REGULAR) return FS_ERROR_INVALID_PATH;
+    if (file_id < 0 || fs.files[file_id]->type != FILE_TYPE_REGULAR) return FS_ERROR_INVALID_PATH;
 
-    uint32_t read_size = (size < fs.files[file_id].size) ? size : fs.files[file_id].size;
-    memcpy(buffer, &fs.data_storage[fs.files[file_id].data_offset], read_size);
+    uint32_t read_size = (size < fs.files[file_id]->size) ? size : fs.files[file_id]->size;
+    memcpy(buffer, &fs.data_storage[fs.files[file_id]->data_offset], read_size);
     return read_size;
 }
 
 void fs_list_directory(int dir_id, bool long_listing) {
-    if (dir_id < 0 || fs.files[dir_id].type != FILE_TYPE_DIRECTORY) {
+    if (dir_id < 0 || fs.files[dir_id]->type != FILE_TYPE_DIRECTORY) {
         console_puts("ls: not a directory\n");
         return;
     }
@@ -163,37 +300,17 @@ void fs_list_directory(int dir_id, bool long_listing) {
         console_puts("----  -------- ----------- --------\n");
     }
 
-    for (uint32_t i = 0; i < fs.file_count; i++) {
-        file_entry_t* f = &fs.files[i];
-        if (f->parent_id == (uint32_t)dir_id) {
-            if (long_listing) {
-                char size_buf[16];
-                char parent_buf[16];
-
-                itoa(f->size, size_buf, 16);
-                itoa(f->parent_id, parent_buf, 16);
-
-                // print type
-                console_putc((f->type == FILE_TYPE_DIRECTORY) ? 'd' : 'f');
-                console_puts("     0x");
-                
-                // print size
-                console_puts(size_buf);
-                console_puts(" ");
-                
-                // print name
-                console_puts(f->name);
-                
-                // align spacing manually if needed (optional)
-                console_puts(" 0x");
-                
-                // print parent ID
-                console_puts(parent_buf);
-                console_puts("\n");
-            } else {
-                console_puts(f->name);
-                console_puts("\n");
-            }
+    for (uint32_t child = fs.files[dir_id]->first_child; child != FS_NO_ENTRY;
+         child = fs.files[child]->next_sibling) {
+        file_entry_t* f = fs.files[child];
+        if (long_listing) {
+            // columns line up with the header above
+            console_printf("%c     0x%-6x %-11s 0x%x\n",
+                           (f->type == FILE_TYPE_DIRECTORY) ? 'd' : 'f',
+                           f->size, f->name, f->parent_id);
+        } else {
+            console_puts(f->name);
+            console_puts("\n");
         }
     }
 }
@@ -210,8 +327,8 @@ static void rebuild_current_path() {
 
     // traverse up to root, pushing names onto stack
     while (curr != fs.root_dir && depth < 32) {
-        strcpy(stack[depth], fs.files[curr].name);
-        curr = fs.files[curr].parent_id;
+        strcpy(stack[depth], fs.files[curr]->name);
+        curr = fs.files[curr]->parent_id;
         depth++;
     }
 
@@ -246,16 +363,8 @@ int fs_change_directory(const char* path) {
     }
 
     if (strcmp(path, "..") == 0) {
-        uint32_t parent = fs.files[fs.current_dir].parent_id;
-        console_puts("[DEBUG] Going up: ");
-        char buf[16];
-        itoa(fs.current_dir, buf, 16);
-        console_puts("from 0x");
-        console_puts(buf);
-        itoa(parent, buf, 16);
-        console_puts(" -> 0x");
-        console_puts(buf);
-        console_puts("\n");
+        uint32_t parent = fs.files[fs.current_dir]->parent_id;
+        console_printf("[DEBUG] Going up: from 0x%x -> 0x%x\n", fs.current_dir, parent);
 
         fs.current_dir = parent;
 
@@ -265,29 +374,19 @@ int fs_change_directory(const char* path) {
     }
 
     int target_id = find_file_in_dir(fs.current_dir, path);
-    console_puts("[DEBUG] find_file_in_dir returned: 0x");
-    char buf[16];
-    itoa(target_id, buf, 16);
-    console_puts(buf);
-    console_puts("\n");
+    console_printf("[DEBUG] find_file_in_dir returned: %d\n", target_id);
 
     if (target_id < 0) {
         console_puts("[DEBUG] Directory not found\n");
         return FS_ERROR_NOT_FOUND;
     }
 
-    if (fs.files[target_id].type != FILE_TYPE_DIRECTORY) {
+    if (fs.files[target_id]->type != FILE_TYPE_DIRECTORY) {
         console_puts("[DEBUG] Target is not a directory\n");
         return FS_ERROR_NOT_DIRECTORY;
     }
 
-    console_puts("[DEBUG] Changing current_dir: 0x");
-    itoa(fs.current_dir, buf, 16);
-    console_puts(buf);
-    console_puts(" -> 0x");
-    itoa(target_id, buf, 16);
-    console_puts(buf);
-    console_puts("\n");
+    console_printf("[DEBUG] Changing current_dir: 0x%x -> 0x%x\n", fs.current_dir, target_id);
 
     fs.current_dir = target_id;
 
@@ -310,12 +409,7 @@ int fs_make_directory(const char* name) {
     // check if directory already exists in current directory
     int existing = find_file_in_dir(fs.current_dir, name);
     if (existing >= 0) {
-        console_puts("[DEBUG] Directory already exists with ID: ");
-        char buf[16];
-        itoa(existing, buf, 16);
-        console_puts("0x");
-        console_puts(buf);
-        console_puts("\n");
+        console_printf("[DEBUG] Directory already exists with ID: 0x%x\n", existing);
         return FS_ERROR_ALREADY_EXISTS;
     }
     
@@ -333,17 +427,15 @@ int fs_make_directory(const char* name) {
     
     int new_id = fs.file_count; 
 
-    console_puts("[DEBUG] Assigning new directory ID: ");
-    char buf[16];
-    itoa(new_id, buf, 10);
-    console_puts(buf);
-    console_puts(" (file_count=");
-    itoa(fs.file_count, buf, 10);
-    console_puts(buf);
-    console_puts(")\n");
+    console_printf("[DEBUG] Assigning new directory ID: %d (file_count=%u)\n",
+                   new_id, fs.file_count);
     
     // fill directory metadata
-    file_entry_t* entry = &fs.files[new_id];
+    file_entry_t* entry = new_entry(new_id);
+    if (!entry) {
+        console_puts("[DEBUG] No memory for the directory entry\n");
+        return FS_ERROR_NO_SPACE;
+    }
     entry->type = FILE_TYPE_DIRECTORY;
     entry->size = 0;
     entry->permissions = PERM_READ | PERM_WRITE | PERM_EXEC;
@@ -352,6 +444,7 @@ int fs_make_directory(const char* name) {
     entry->modified_time = system_time;
     entry->data_offset = 0;
     strcpy(entry->name, name);
+    add_entry(new_id);
     
     // update filesystem counters
     fs.file_count++;
@@ -359,20 +452,9 @@ int fs_make_directory(const char* name) {
     
     // print debug info
     console_puts("[DEBUG] Directory created successfully\n");
-    console_puts("[DEBUG] New directory ID: 0x");
-    itoa(new_id, buf, 16);
-    console_puts(buf);
-    console_puts(" (parent: 0x");
-    itoa(fs.current_dir, buf, 16);
-    console_puts(buf);
-    console_puts(")\n");
-    console_puts("[DEBUG] Updated file_count: ");
-    itoa(fs.file_count, buf, 10);
-    console_puts(buf);
-    console_puts(", next_file_id: ");
-    itoa(fs.next_file_id, buf, 10);
-    console_puts(buf);
-    console_puts("\n");
+    console_printf("[DEBUG] New directory ID: 0x%x (parent: 0x%x)\n", new_id, fs.current_dir);
+    console_printf("[DEBUG] Updated file_count: %u, next_file_id: %u\n",
+                   fs.file_count, fs.next_file_id);
     
     return FS_SUCCESS;
 }
@@ -380,48 +462,22 @@ int fs_make_directory(const char* name) {
 int fs_delete_file(const char* name) {
     int file_id = find_file_in_dir(fs.current_dir, name);
     if (file_id < 0) return FS_ERROR_NOT_FOUND;
+    if ((uint32_t)file_id == fs.root_dir) return FS_ERROR_PERMISSION_DENIED;
+    if (fs.files[file_id]->first_child != FS_NO_ENTRY) return FS_ERROR_NOT_EMPTY;
 
-    uint32_t old_last_id = fs.file_count - 1;
-
-    if (file_id < (int)old_last_id) {
-        for (uint32_t i = 0; i < fs.file_count; i++) {
-            if (fs.files[i].parent_id == old_last_id) {
-                fs.files[i].parent_id = file_id;
-            }
-        }
-        if (fs.current_dir == old_last_id) {
-            fs.current_dir = file_id;
-        }
-        fs.files[file_id] = fs.files[old_last_id];
-    }
-
-    fs.file_count--;
+    remove_entry(file_id);
     return FS_SUCCESS;
 }
 
 int fs_remove_directory(const char* name) {
     int dir_id = find_file_in_dir(fs.current_dir, name);
     if (dir_id < 0) return FS_ERROR_NOT_FOUND;
-    if (fs.files[dir_id].type != FILE_TYPE_DIRECTORY) return FS_ERROR_NOT_DIRECTORY;
+    if ((uint32_t)dir_id == fs.root_dir) return FS_ERROR_PERMISSION_DENIED;
+    if (fs.files[dir_id]->type != FILE_TYPE_DIRECTORY) return FS_ERROR_NOT_DIRECTORY;
 
-    for (uint32_t i = 0; i < fs.file_count; i++) {
-        if (fs.files[i].parent_id == (uint32_t)dir_id) return FS_ERROR_NOT_EMPTY;
-    }
+    if (fs.files[dir_id]->first_child != FS_NO_ENTRY) return FS_ERROR_NOT_EMPTY;
 
-    uint32_t old_last_id = fs.file_count - 1;
-    if (dir_id < (int)old_last_id) {
-        for (uint32_t i = 0; i < fs.file_count; i++) {
-            if (fs.files[i].parent_id == old_last_id) {
-                fs.files[i].parent_id = dir_id;
-            }
-        }
-        if (fs.current_dir == old_last_id) {
-            fs.current_dir = dir_id;
-        }
-        fs.files[dir_id] = fs.files[old_last_id];
-    }
-
-    fs.file_count--;
+    remove_entry(dir_id);
     return FS_SUCCESS;
 }
 
@@ -444,14 +500,19 @@ char* fs_get_current_path_ptr(void) {
 file_entry_t* fs_get_file(const char* name) {
     int file_id = find_file_in_dir(fs.current_dir, name);
     if (file_id < 0) return NULL;
-    return &fs.files[file_id];
+    return fs.files[file_id];
 }
 
 int fs_copy_file(const char* src, const char* dest) {
-    char buffer[MAX_FILE_SIZE];
+    size_t mark = scratch_mark();
+    char* buffer = scratch_alloc(MAX_FILE_SIZE);
+    if (!buffer) return FS_ERROR_NO_SPACE;
+
     int bytes_read = fs_read_file(src, buffer, MAX_FILE_SIZE);
-    if (bytes_read < 0) return bytes_read;
-    return fs_write_file(dest, buffer, bytes_read);
+    int ret = (bytes_read < 0) ? bytes_read : fs_write_file(dest, buffer, bytes_read);
+
+    scratch_release(mark);
+    return ret;
 }
 
 int fs_move_file(const char* src, const char* dest) {
@@ -459,21 +520,25 @@ int fs_move_file(const char* src, const char* dest) {
     if (!src_file) return FS_ERROR_NOT_FOUND;
     if (fs_get_file(dest)) return FS_ERROR_ALREADY_EXISTS;
 
-    int ret = fs_create_file(dest, src_file->type);
-    if (ret != FS_SUCCESS) return ret;
+    size_t mark = scratch_mark();
+    uint8_t* buffer = scratch_alloc(MAX_FILE_SIZE);
+    if (!buffer) return FS_ERROR_NO_SPACE;
 
-    uint8_t buffer[MAX_FILE_SIZE];
-    uint32_t bytes_read = fs_read_file(src, buffer, src_file->size);
-    if (bytes_read != src_file->size) {
-        fs_delete_file(dest);
-        return FS_ERROR_PERMISSION_DENIED;
+    int ret = fs_create_file(dest, src_file->type);
+    if (ret != FS_SUCCESS) {
+        scratch_release(mark);
+        return ret;
     }
 
-    if (fs_write_file(dest, buffer, src_file->size) != FS_SUCCESS) {
+    uint32_t bytes_read = fs_read_file(src, buffer, src_file->size);
+    if (bytes_read != src_file->size ||
+        fs_write_file(dest, buffer, src_file->size) != FS_SUCCESS) {
         fs_delete_file(dest);
+        scratch_release(mark);
         return FS_ERROR_PERMISSION_DENIED;
     }
 
+    scratch_release(mark);
     return fs_delete_file(src);
 }
 
@@ -481,9 +546,13 @@ int fs_find_file(const char* pattern) {
     console_puts("Find results:\n");
     int found = 0;
 
+    str_search_t search;
+    str_search_init(&search, pattern, strlen(pattern));
+
     for (uint32_t i = 0; i < fs.file_count; i++) {
-        if (strstr(fs.files[i].name, pattern)) {
-            console_puts(fs.files[i].name);
+        const char* name = fs.files[i]->name;
+        if (str_search_find(&search, name, strlen(name))) {
+            console_puts(fs.files[i]->name);
             console_puts("\n");
             found++;
         }
@@ -494,25 +563,32 @@ int fs_find_file(const char* pattern) {
 }
 
 int fs_grep_file(const char* filename, const char* pattern) {
-    char buffer[MAX_FILE_SIZE];
+    size_t mark = scratch_mark();
+    char* buffer = scratch_alloc(MAX_FILE_SIZE);
+    if (!buffer) return FS_ERROR_NO_SPACE;
+
     int bytes_read = fs_read_file(filename, buffer, MAX_FILE_SIZE - 1);
-    if (bytes_read < 0) return bytes_read;
+    if (bytes_read < 0) {
+        scratch_release(mark);
+        return bytes_read;
+    }
+
+    int found = memmem(buffer, bytes_read, pattern, strlen(pattern)) != NULL;
+    scratch_release(mark);
 
-    buffer[bytes_read] = '\0';
-    if (strstr(buffer, pattern)) {
+    if (found) {
         console_puts("Pattern found in ");
         console_puts(filename);
         console_puts("\n");
-        return 1;
     }
 
-    return 0;
+    return found;
 }
 
 int fs_touch_file(const char* name) {
     int file_id = find_file_in_dir(fs.current_dir, name);
     if (file_id >= 0) {
-        fs.files[file_id].modified_time = system_time++;
+        fs.files[file_id]->modified_time = system_time++;
         return FS_SUCCESS;
     }
 
@@ -524,18 +600,15 @@ int fs_resolve_path(const char* path) {
     if (!path || path[0] == '\0') return -1;
 
     uint32_t dir = (path[0] == '/') ? fs.root_dir : fs.current_dir;
-    char temp_path[MAX_PATH];
-    strncpy(temp_path, path, MAX_PATH - 1);
-    temp_path[MAX_PATH - 1] = '\0';
-
-    char* token = strtok(temp_path, "/");
-    while (token != NULL) {
-        int next = find_file_in_dir(dir, token);
-        if (next < 0 || fs.files[next].type != FILE_TYPE_DIRECTORY) {
+    const char* cursor = path;
+    str_span_t component;
+
+    while (str_next_token(&cursor, "/", &component)) {
+        int next = find_span_in_dir(dir, component);
+        if (next < 0 || fs.files[next]->type != FILE_TYPE_DIRECTORY) {
             return -1;
         }
         dir = next;
-        token = strtok(NULL, "/");
     }
 
     return (int)dir;
@@ -557,10 +630,10 @@ int fs_getcwd(char* buffer, uint32_t size) {
     uint32_t current = fs.current_dir;
 
     while (current != fs.root_dir && depth < 32) {
-        strncpy(path_stack[depth], fs.files[current].name, MAX_FILENAME);
+        strncpy(path_stack[depth], fs.files[current]->name, MAX_FILENAME);
         path_stack[depth][MAX_FILENAME - 1] = '\0';
         depth++;
-        current = fs.files[current].parent_id;
+        current = fs.files[current]->parent_id;
 
         if (current == fs.current_dir) break;
     }
@@ -10,6 +10,15 @@
 #define MAX_PATH_LENGTH 256
 #define MAX_PATH 256
 
+// open-addressing index over (parent_id, name); a power of two at least
+// twice MAX_FILES keeps probe sequences short
+#define FS_INDEX_SIZE (MAX_FILES * 2)
+_Static_assert((FS_INDEX_SIZE & (FS_INDEX_SIZE - 1)) == 0,
+               "FS_INDEX_SIZE must be a power of two (probes wrap with a mask)");
+
+// no entry, for the child and sibling links
+#define FS_NO_ENTRY 0xFFFFFFFFU
+
 
 // file types
 typedef enum {
@@ -33,6 +42,12 @@ typedef struct {
     uint32_t created_time;
     uint32_t modified_time;
     uint32_t data_offset;
+    uint32_t name_hash;         // of name alone, so re-parenting keeps it
+    // children of a directory in creation order (the root is not its own child)
+    uint32_t first_child;
+    uint32_t last_child;
+    uint32_t next_sibling;
+    uint32_t prev_sibling;
 } file_entry_t;
 
 // directory entry structure
@@ -43,7 +58,7 @@ typedef struct {
 
 // main filesystem structure
 typedef struct {
-    file_entry_t files[MAX_FILES];
+    file_entry_t* files[MAX_FILES];   // from the fs_node slab cache
     uint32_t file_count;
     uint32_t current_dir;
     uint32_t root_dir;
@@ -51,6 +66,7 @@ typedef struct {
     uint8_t data_storage[MAX_FILES * MAX_FILE_SIZE];
     uint32_t data_usage;
     uint32_t next_file_id;
+    uint16_t index[FS_INDEX_SIZE];   // file id + 1, 0 for an empty slot
 } filesystem_t;
 
 #define FS_SUCCESS 0
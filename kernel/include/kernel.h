@@ -12,10 +12,14 @@
 // kernel configuration
 #define KERNEL_STACK_SIZE (4 * 1024)  // 4KB stack
 #define MAX_INTERRUPTS 32
+#define MAX_HARTS 4                    // harts with their own allocator caches
 
 // RISC-V specific definitions
 #define MSTATUS_MIE  (1 << 3)   // Machine Interrupt Enable
 #define MSTATUS_MPIE (1 << 7)   // Machine Previous Interrupt Enable
+#define MSTATUS_VS_INITIAL (1 << 9)   // vector unit on, state clean
+
+#define MISA_EXT(letter) (1UL << ((letter) - 'A'))
 
 // CSR (control and status register) access macros
 #define CSR_READ(csr) ({                    \
@@ -47,7 +51,7 @@
 })
 
 // function prototypes
-void kernel_main(void);
+void kernel_main(unsigned long hart_id, const void* dtb);
 void kernel_panic(const char* message);
 void kernel_print_banner(void);
 
@@ -55,10 +59,16 @@ void kernel_print_banner(void);
 typedef void (*interrupt_handler_t)(void);
 void register_interrupt_handler(int irq, interrupt_handler_t handler);
 
+// multi-letter ISA extensions found in the device tree
+#define ISA_EXT_ZBB (1 << 0)
+#define ISA_EXT_ZBC (1 << 1)
+
 // system information structure
 typedef struct {
     uint32_t hart_id;
     uint32_t misa;
+    uint32_t isa_extensions;   // ISA_EXT_* bits
+    const void* dtb;
     uint64_t memory_size;
     const char* cpu_model;
 } system_info_t;
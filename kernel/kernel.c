@@ -1,10 +1,15 @@
 #include "include/kernel.h"
 #include "drivers/console.h"
+#include "drivers/fdt.h"
+#include "drivers/timer.h"
 #include "memory/memory.h"
+#include "memory/page.h"
+#include "memory/scratch.h"
 #include "shell/shell.h"
 #include "fs/fs.h"            
 #include "include/types.h"
 #include "../lib/string.h"
+#include "../lib/hash.h"
 #include "../editor/editor.h"
 
 system_info_t g_system_info = {0};
@@ -73,31 +78,47 @@ void test_input_output(void) {
     console_println("Input/Output test completed!");
 }
 
-void kernel_main() {
+void kernel_main(unsigned long hart_id, const void* dtb) {
     console_init();
+    
+    // pick string routines before anything bulk-copies; misa has no bit for
+    // Zbb, so that comes from the device tree
+    unsigned int string_features = 0;
+    g_system_info.hart_id = hart_id;
+    g_system_info.dtb = dtb;
+    g_system_info.misa = CSR_READ(misa);
+    if (g_system_info.misa & MISA_EXT('V')) {
+        CSR_SET(mstatus, MSTATUS_VS_INITIAL);
+        string_features |= STRING_FEATURE_VECTOR;
+    }
+    if (fdt_cpu_has_extension(dtb, "zbb")) {
+        g_system_info.isa_extensions |= ISA_EXT_ZBB;
+        string_features |= STRING_FEATURE_ZBB;
+    }
+    string_init(string_features);
+    
+    unsigned int hash_features = 0;
+    if (fdt_cpu_has_extension(dtb, "zbc")) {
+        g_system_info.isa_extensions |= ISA_EXT_ZBC;
+        hash_features |= HASH_FEATURE_ZBC;
+    }
+    hash_init(hash_features);
+    timer_init(dtb);
+    
+    page_init();
     memory_init();
+    scratch_init();
 
     fs_init();
     console_puts("[DEBUG] fs_init() called\n");
 
-    char buf[16];
-    console_puts("[DEBUG] Filesystem state before shell: file_count=");
-    itoa(fs.file_count, buf, 10);
-    console_puts(buf);
-    console_puts(", current_dir=");
-    itoa(fs.current_dir, buf, 10);
-    console_puts(buf);
-    console_puts(", next_file_id=");
-    itoa(fs.next_file_id, buf, 10);
-    console_puts(buf);
-    console_puts("\n");
+    console_printf("[DEBUG] Filesystem state before shell: file_count=%u, current_dir=%u, next_file_id=%u\n",
+                   fs.file_count, fs.current_dir, fs.next_file_id);
 
     kernel_print_banner();
     console_println("RISC-V kernel loaded successfully");
 
     console_println("\n--- System Information ---");
-    g_system_info.hart_id = CSR_READ(mhartid);
-    g_system_info.misa = CSR_READ(misa);
 
     console_puts("Hart ID: ");
     console_put_hex(g_system_info.hart_id);
@@ -116,7 +137,15 @@ void kernel_main() {
     if (g_system_info.misa & (1 << 12)) console_puts("M ");
     if (g_system_info.misa & (1 << 18)) console_puts("S ");
     if (g_system_info.misa & (1 << 20)) console_puts("U ");
+    if (g_system_info.misa & (1 << 21)) console_puts("V ");
+    if (g_system_info.isa_extensions & ISA_EXT_ZBB) console_puts("Zbb ");
+    if (g_system_info.isa_extensions & ISA_EXT_ZBC) console_puts("Zbc ");
+    console_puts("\n");
+    
+    console_puts("String routines: ");
+    console_puts(string_impl_name());
     console_puts("\n");
+    console_printf("CRC32C: %s\n", hash_crc32c_impl_name());
 
     console_println("\n--- Memory Layout ---");
     extern char bss_start[], bss_end[], kernel_end[], stack_top[];
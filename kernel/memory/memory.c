@@ -1,4 +1,5 @@
 #include "memory.h"
+#include "page.h"
 #include "../drivers/console.h"
 #include "../include/kernel.h"
 #include "../../lib/string.h"
@@ -6,38 +7,316 @@
 // heap allocator constants
 #define HEAP_SIZE (1024 * 1024)  // 1MB heap
 #define MIN_BLOCK_SIZE 32
+#define MAX_REQUEST_SIZE ((size_t)-1 / 2)   // larger sizes can't be rounded safely
 #define BLOCK_HEADER_SIZE sizeof(block_header_t)
+#define BLOCK_FOOTER_SIZE sizeof(block_footer_t)
+#define BLOCK_OVERHEAD (BLOCK_HEADER_SIZE + BLOCK_FOOTER_SIZE)
+#define FOOTER_FREE 1
+
+// block flags
+#define BLOCK_ZEROED 0x1   // payload is known to be all zero bytes
+#define BLOCK_CACHED 0x2   // held by a magazine or the deferred free queue
+
+// the heap starts with the static arena and grows in page-backed arenas
+#define MAX_ARENAS 64
+#define ARENA_MIN_ORDER 4    // 64KB
+#define ARENA_GROW_ORDER 8   // 1MB for the first page-backed arena, doubling after
+#define ARENA_CHUNKS (PAGE_MAX_FRAMES >> ARENA_MIN_ORDER)
+#define ARENA_FENCE_SIZE (BLOCK_FOOTER_SIZE + BLOCK_HEADER_SIZE)
+
+// size classes: 16-byte steps below SMALL_CLASS_LIMIT, then four
+// sub-classes per power of two; the last class takes everything larger
+#define NUM_SIZE_CLASSES 64
+#define SMALL_CLASS_SHIFT 4
+#define SMALL_CLASS_LIMIT_SHIFT 9
+#define SMALL_CLASS_LIMIT (1 << SMALL_CLASS_LIMIT_SHIFT)
+#define NUM_SMALL_CLASSES (SMALL_CLASS_LIMIT >> SMALL_CLASS_SHIFT)
+#define SUBCLASS_BITS 2
+#define SUBCLASSES (1 << SUBCLASS_BITS)
+
+// per-hart magazines cache small blocks in front of the size-class lists;
+// magazine class c holds blocks of at least c * 16 bytes
+#define MAGAZINE_ROUNDS 16
+#define MAGAZINE_CLASSES NUM_SMALL_CLASSES
+#define MAGAZINE_REFILL (MAGAZINE_ROUNDS / 2)
+#define DEPOT_MAX_FULL 4   // full magazines parked per class before flushing
+
+typedef struct magazine {
+    struct magazine* next;   // depot list link
+    int rounds;              // blocks currently loaded
+    size_t bytes;            // their size, headers and footers included
+    block_header_t* blocks[MAGAZINE_ROUNDS];
+} magazine_t;
+
+// a hart allocates from loaded and swaps with previous before touching the
+// depot, so alternating alloc/free at a magazine boundary stays local
+typedef struct {
+    magazine_t* loaded;
+    magazine_t* previous;
+} hart_cache_t;
+
+typedef struct {
+    magazine_t* full;
+    magazine_t* empty;
+    int num_full;
+} depot_t;
+
+// allocation-site profiling (build with MEMPROF=1)
+#ifdef MEMPROF
+#define MEMPROF_SITES_SHIFT 7
+#define MEMPROF_SITES (1 << MEMPROF_SITES_SHIFT)
+#define MEMPROF_CALLER() __builtin_return_address(0)
+
+typedef struct {
+    void* site;
+    size_t live_bytes;
+    size_t live_blocks;
+    size_t total_allocs;
+    size_t total_frees;
+    uint64_t total_lifetime;   // cycles summed over freed blocks
+} memprof_site_t;
+
+static void memprof_track(block_header_t* block, void* site, size_t size);
+static void memprof_untrack(block_header_t* block);
+static void memprof_resize(block_header_t* block, size_t size);
+#else
+#define MEMPROF_CALLER() NULL
+#define memprof_track(block, site, size) ((void)(site), (void)(size))
+#define memprof_untrack(block) ((void)0)
+#define memprof_resize(block, size) ((void)0)
+#endif
+
+// kmalloc/kfree trace ring buffer (build with KTRACE=1); replayed on the
+// host by tools/kmalloc_replay.c
+#ifdef KMALLOC_TRACE
+#define KTRACE_ENTRIES 4096   // power of two
+
+typedef struct {
+    uint64_t cycles;
+    uint32_t id;
+    uint32_t size;
+    uint32_t align;
+    char op;                  // 'A' alloc, 'C' calloc, 'R' realloc, 'F' free
+} ktrace_entry_t;
+
+static void ktrace_alloc(void* ptr, char op, size_t size, size_t align);
+static void ktrace_free(void* ptr);
+static uint32_t ktrace_id(void* ptr);
+static void ktrace_realloc(void* old_ptr, void* new_ptr, uint32_t id, size_t size);
+#else
+#define ktrace_alloc(ptr, op, size, align) ((void)0)
+#define ktrace_free(ptr) ((void)0)
+#define ktrace_id(ptr) 0
+#define ktrace_realloc(old_ptr, new_ptr, id, size) ((void)(id))
+#endif
 
 // declarations for static functions
+static void heap_free(void* ptr);
+static void heap_free_block(block_header_t* block);
+static block_header_t* magazine_alloc(size_t size);
+static int depot_reclaim(void);
+static void magazine_reap(unsigned int hart);
+static int magazine_free(block_header_t* block);
 static block_header_t* find_free_block(size_t size);
 static void split_block(block_header_t* block, size_t size);
-static void merge_free_blocks(void);
+static block_header_t* coalesce_block(block_header_t* block);
+static int size_class(size_t size);
+static size_t size_class_base(int cls);
+static size_t largest_free_block(void);
+static size_t class_alloc_count(int cls);
+static int arena_add(char* start, size_t size, int page_order);
+static int heap_grow(size_t size);
+static void free_list_insert(block_header_t* block);
+static void free_list_remove(block_header_t* block);
+
+// contiguous heap region bracketed by fence blocks
+typedef struct {
+    char* start;
+    size_t size;
+    int page_order;   // -1 for the static arena
+} arena_t;
 
 // global heap memory (static allocation for simplicity)
 static char heap_memory[HEAP_SIZE];
-static block_header_t* heap_start = NULL;
 static int memory_initialized = 0;
 
-// statistics
+// released arenas leave an empty slot rather than compacting the table, so
+// find_arena can run without the heap lock
+static arena_t arenas[MAX_ARENAS];
+static int num_arena_slots = 0;
+static int num_arenas = 0;
+
+// page-backed arenas are buddy blocks of at least 2^ARENA_MIN_ORDER frames,
+// naturally aligned, so every such chunk of page frames belongs to at most
+// one arena; holds its slot + 1, or 0
+static uint8_t arena_of_chunk[ARENA_CHUNKS];
+
+// segregated free lists, one per size class, plus a bitmap of non-empty classes
+static block_header_t* free_lists[NUM_SIZE_CLASSES];
+static uint64_t free_class_bitmap = 0;
+
+// per-class histograms: free blocks now, allocation requests since boot
+static size_t class_free_blocks[NUM_SIZE_CLASSES];
+static size_t class_allocs[NUM_SIZE_CLASSES];
+
+// statistics, kept up to date by every allocator operation
 static memory_stats_t stats = {0};
 
+// heap_lock guards the free lists, arenas and stats; depot_lock the depot
+static volatile int heap_lock = 0;
+static volatile int depot_lock = 0;
+
+// blocks freed while another hart held heap_lock, linked through next_free
+// and returned to the heap by the next lock holder
+static block_header_t* volatile deferred_frees = NULL;
+
+static hart_cache_t hart_caches[MAX_HARTS][MAGAZINE_CLASSES];
+static size_t hart_cached_blocks[MAX_HARTS];
+static depot_t depots[MAGAZINE_CLASSES];
+static size_t depot_cached_blocks = 0;
+static size_t depot_cached_bytes = 0;
+static size_t num_magazines = 0;
+
+// heap_alloc's counters see magazine refills and the magazines themselves
+// as allocations, and never see magazine hits, which run without heap_lock
+// and are counted here per hart; memory_get_stats corrects for both
+static size_t hart_class_allocs[MAX_HARTS][NUM_SMALL_CLASSES];
+
+#if defined(MEMPROF) || defined(KMALLOC_TRACE)
+// the profiler and trace run outside heap_lock and share this one
+static volatile int debug_lock = 0;
+#endif
+
+#ifdef MEMPROF
+// open-addressed by call site; sites that don't fit share the overflow slot
+static memprof_site_t memprof_sites[MEMPROF_SITES];
+static memprof_site_t memprof_overflow;
+#endif
+
+#ifdef KMALLOC_TRACE
+static ktrace_entry_t ktrace_ring[KTRACE_ENTRIES];
+static uint64_t ktrace_head = 0;      // events recorded since the last clear
+static uint32_t ktrace_next_id = 0;
+#endif
+
+#if defined(MEMPROF) || defined(KMALLOC_TRACE)
+static inline uint64_t heap_cycles(void) {
+    return CSR_READ(mcycle);
+}
+#endif
+
+static inline block_footer_t* block_footer(block_header_t* block) {
+    return (block_footer_t*)((char*)block + BLOCK_HEADER_SIZE + block->size);
+}
+
+static inline block_header_t* next_block(block_header_t* block) {
+    return (block_header_t*)((char*)block + BLOCK_OVERHEAD + block->size);
+}
+
+static inline void set_footer(block_header_t* block) {
+    block_footer(block)->size_and_free = block->size | (block->is_free ? FOOTER_FREE : 0);
+}
+
+// kmalloc's block size for a request: a multiple of 8, at least
+// MIN_BLOCK_SIZE; 0 for a request too big to round without wrapping
+static inline size_t block_size_for(size_t size) {
+    if (size > MAX_REQUEST_SIZE) {
+        return 0;
+    }
+    size = (size + 7) & ~(size_t)7;
+    return (size < MIN_BLOCK_SIZE) ? MIN_BLOCK_SIZE : size;
+}
+
+static inline unsigned int current_hart(void) {
+#ifdef __riscv
+    return CSR_READ(mhartid);
+#else
+    return 0;   // host build (tools/kmalloc_replay)
+#endif
+}
+
+// magazines only hold blocks from the static arena: a cached block in a
+// page-backed arena would keep the arena from going back to the pages
+static inline int in_static_arena(block_header_t* block) {
+    return (char*)block >= heap_memory && (char*)block < heap_memory + HEAP_SIZE;
+}
+
+static inline void spin_lock(volatile int* lock) {
+    while (__sync_lock_test_and_set(lock, 1)) {
+    }
+}
+
+static inline int spin_trylock(volatile int* lock) {
+    return __sync_lock_test_and_set(lock, 1) == 0;
+}
+
+static inline void spin_unlock(volatile int* lock) {
+    __sync_lock_release(lock);
+}
+
+// return frees queued while the lock was held elsewhere; caller holds heap_lock
+static void heap_drain_deferred(void) {
+    block_header_t* block = __sync_lock_test_and_set(&deferred_frees, NULL);
+    while (block) {
+        block_header_t* next = block->next_free;
+        heap_free_block(block);
+        block = next;
+    }
+}
+
+static void heap_lock_acquire(void) {
+    spin_lock(&heap_lock);
+    heap_drain_deferred();
+}
+
+static inline void heap_lock_release(void) {
+    spin_unlock(&heap_lock);
+}
+
+// the static arena is always slot 0
+static arena_t* find_arena(void* ptr) {
+    if (in_static_arena(ptr)) {
+        return &arenas[0];
+    }
+    
+    size_t frame = page_frame_number(ptr);
+    if (frame >= PAGE_MAX_FRAMES || !arena_of_chunk[frame >> ARENA_MIN_ORDER]) {
+        return NULL;
+    }
+    return &arenas[arena_of_chunk[frame >> ARENA_MIN_ORDER] - 1];
+}
+
+static void arena_map(arena_t* arena, uint8_t value) {
+    size_t chunk = page_frame_number(arena->start) >> ARENA_MIN_ORDER;
+    size_t chunks = (size_t)1 << (arena->page_order - ARENA_MIN_ORDER);
+    for (size_t i = 0; i < chunks; i++) {
+        arena_of_chunk[chunk + i] = value;
+    }
+}
+
+static void arena_release(arena_t* arena) {
+    stats.total_memory -= arena->size;
+    stats.used_memory -= arena->size;
+    arena_map(arena, 0);
+    free_pages(arena->start, arena->page_order);
+    
+    arena->size = 0;
+    arena->start = NULL;
+    num_arenas--;
+}
+
 void memory_init(void) {
     if (memory_initialized) {
         return;
     }
     
-    // Initialize the first block to cover the entire heap
-    heap_start = (block_header_t*)heap_memory;
-    heap_start->size = HEAP_SIZE - BLOCK_HEADER_SIZE;
-    heap_start->is_free = 1;
-    heap_start->next = NULL;
-    
-    // Initialize statistics
-    stats.total_memory = HEAP_SIZE;
-    stats.used_memory = BLOCK_HEADER_SIZE; // Just the header initially
-    stats.free_memory = HEAP_SIZE - BLOCK_HEADER_SIZE;
+    // Initialize statistics; arena_add accounts for the heap itself
+    stats.total_memory = 0;
+    stats.used_memory = 0;
+    stats.free_memory = 0;
     stats.num_allocations = 0;
-    stats.num_free_blocks = 1;
+    stats.num_free_blocks = 0;
+    arena_add(heap_memory, HEAP_SIZE, -1);
     
     memory_initialized = 1;
     
@@ -46,7 +325,10 @@ void memory_init(void) {
     console_puts(" bytes\n");
 }
 
-void* kmalloc(size_t size) {
+// take a block of at least size bytes off the free lists and mark it used;
+// its BLOCK_ZEROED flag is left for the caller to inspect. Only adds pages
+// to the heap when grow is set. Caller holds heap_lock.
+static block_header_t* heap_alloc(size_t size, int grow) {
     if (!memory_initialized) {
         kernel_panic("kmalloc called before memory_init");
         return NULL;
@@ -56,38 +338,281 @@ void* kmalloc(size_t size) {
         return NULL;
     }
     
-    // align size to 8-byte boundary
-    size = (size + 7) & ~7;
-    
-    // ensure minimum block size
-    if (size < MIN_BLOCK_SIZE) {
-        size = MIN_BLOCK_SIZE;
+    size = block_size_for(size);
+    if (!size) {
+        return NULL;
     }
     
+    // find_free_block also unlinks the block from its free list
     block_header_t* block = find_free_block(size);
     
-    if (!block) {
-        return NULL;
+    // blocks parked in the depot may coalesce into something big enough
+    if (!block && depot_reclaim()) {
+        block = find_free_block(size);
     }
     
-    // split the block if it's much larger than needed
-    if (block->size > size + BLOCK_HEADER_SIZE + MIN_BLOCK_SIZE) {
-        split_block(block, size);
+    // out of heap: add an arena from the page allocator and retry
+    if (!block && grow && heap_grow(size) == 0) {
+        block = find_free_block(size);
+    }
+    
+    if (!block) {
+        return NULL;
     }
     
     // mark block as used
     block->is_free = 0;
     
-    // update statistics
-    stats.used_memory += block->size + BLOCK_HEADER_SIZE;
-    stats.free_memory -= block->size + BLOCK_HEADER_SIZE;
+    // split the block if it's much larger than needed
+    split_block(block, size);
+    set_footer(block);
+    
     stats.num_allocations++;
+    class_allocs[size_class(size)]++;
+    if (stats.used_memory > stats.peak_used_memory) {
+        stats.peak_used_memory = stats.used_memory;
+    }
+    return block;
+}
+
+// site is the return address charged for the allocation under MEMPROF
+// the heap proper, then whatever this hart's magazines hoard, and only
+// then new pages
+static block_header_t* heap_alloc_slow(size_t size) {
+    heap_lock_acquire();
+    block_header_t* block = heap_alloc(size, 0);
+    heap_lock_release();
+    
+    if (!block) {
+        magazine_reap(current_hart());
+        heap_lock_acquire();
+        block = heap_alloc(size, 1);
+        heap_lock_release();
+    }
+    return block;
+}
+
+static void* kmalloc_at(size_t size, void* site) {
+    block_header_t* block = magazine_alloc(size);
+    if (!block) {
+        block = heap_alloc_slow(size);
+    }
+    if (!block) {
+        return NULL;
+    }
+    
+    // the caller owns the payload now, so it can no longer be assumed zero
+    block->flags = 0;
+    memprof_track(block, site, size);
     
     // return pointer to data (after header)
     return (char*)block + BLOCK_HEADER_SIZE;
 }
 
+void* kmalloc(size_t size) {
+    void* ptr = kmalloc_at(size, MEMPROF_CALLER());
+    ktrace_alloc(ptr, 'A', size, 8);
+    return ptr;
+}
+
+void* kcalloc(size_t count, size_t size) {
+    if (size && count > MAX_REQUEST_SIZE / size) {
+        return NULL;
+    }
+    
+    block_header_t* block = magazine_alloc(count * size);
+    if (!block) {
+        block = heap_alloc_slow(count * size);
+    }
+    if (!block) {
+        return NULL;
+    }
+    
+    // memory never handed out since boot is still zero from the BSS clear
+    void* ptr = (char*)block + BLOCK_HEADER_SIZE;
+    if (!(block->flags & BLOCK_ZEROED)) {
+        memset(ptr, 0, count * size);
+    }
+    block->flags = 0;
+    memprof_track(block, MEMPROF_CALLER(), count * size);
+    ktrace_alloc(ptr, 'C', count * size, 8);
+    
+    return ptr;
+}
+
+// caller holds heap_lock
+static block_header_t* heap_alloc_aligned(size_t size, size_t align, int grow) {
+    size = block_size_for(size);
+    if (!size) {
+        return NULL;
+    }
+    
+    // leave room to push the payload to an aligned address whose leading
+    // gap is either empty or large enough to stand as a free block
+    size_t gap_min = BLOCK_OVERHEAD + MIN_BLOCK_SIZE;
+    if (size > (size_t)-1 - align - gap_min) {
+        return NULL;
+    }
+    block_header_t* block = heap_alloc(size + align + gap_min, grow);
+    if (!block) {
+        return NULL;
+    }
+    
+    uintptr_t payload = (uintptr_t)block + BLOCK_HEADER_SIZE;
+    uintptr_t aligned = ALIGN_UP(payload, align);
+    if (aligned != payload && aligned - payload < gap_min) {
+        aligned = ALIGN_UP(payload + gap_min, align);
+    }
+    
+    size_t gap = aligned - payload;
+    if (gap) {
+        // carve the leading gap off as a free block; its predecessor cannot
+        // be free, since the block came off a free list
+        block_header_t* aligned_block = (block_header_t*)(aligned - BLOCK_HEADER_SIZE);
+        aligned_block->size = block->size - gap;
+        aligned_block->is_free = 0;
+        aligned_block->flags = block->flags;
+        
+        block->size = gap - BLOCK_OVERHEAD;
+        block->is_free = 1;
+        set_footer(block);
+        free_list_insert(block);
+        
+        block = aligned_block;
+        stats.align_padding_reclaimed += gap;
+    }
+    
+    // give back the unused tail, then hand the payload to the caller
+    split_block(block, size);
+    set_footer(block);
+    block->flags = 0;
+    
+    stats.aligned_allocations++;
+    stats.align_padding_wasted += block->size - size;
+    return block;
+}
+
+static void* kmalloc_aligned_at(size_t size, size_t align, void* site) {
+    // align must be a power of two; kmalloc already guarantees 8 bytes
+    if (align & (align - 1)) {
+        return NULL;
+    }
+    if (align <= 8) {
+        return kmalloc_at(size, site);
+    }
+    
+    if (size == 0) {
+        return NULL;
+    }
+    
+    heap_lock_acquire();
+    block_header_t* block = heap_alloc_aligned(size, align, 0);
+    heap_lock_release();
+    
+    if (!block) {
+        magazine_reap(current_hart());
+        heap_lock_acquire();
+        block = heap_alloc_aligned(size, align, 1);
+        heap_lock_release();
+    }
+    if (!block) {
+        return NULL;
+    }
+    
+    memprof_track(block, site, size);
+    return (char*)block + BLOCK_HEADER_SIZE;
+}
+
+void* kmalloc_aligned(size_t size, size_t align) {
+    void* ptr = kmalloc_aligned_at(size, align, MEMPROF_CALLER());
+    ktrace_alloc(ptr, 'A', size, align);
+    return ptr;
+}
+
+void* kmalloc_flags(size_t size, unsigned int flags) {
+    void* ptr;
+    size_t align = 8;
+    
+    if (flags & KMALLOC_CACHE_ALIGNED) {
+        align = CACHE_LINE_SIZE;
+        ptr = kmalloc_aligned_at(size, align, MEMPROF_CALLER());
+    } else {
+        ptr = kmalloc_at(size, MEMPROF_CALLER());
+    }
+    ktrace_alloc(ptr, 'A', size, align);
+    return ptr;
+}
+
+static void* heap_realloc(void* ptr, size_t size, void* site) {
+    if (!ptr) {
+        return kmalloc_at(size, site);
+    }
+    
+    if (size == 0) {
+        heap_free(ptr);
+        return NULL;
+    }
+    
+    block_header_t* block = (block_header_t*)((char*)ptr - BLOCK_HEADER_SIZE);
+    if (!find_arena(block) || block->is_free || (block->flags & BLOCK_CACHED)) {
+        console_println("WARNING: Invalid realloc() call");
+        return NULL;
+    }
+    
+    // same rounding as kmalloc; a size that can't be rounded fails and
+    // leaves the block alone
+    size_t aligned = block_size_for(size);
+    if (!aligned) {
+        return NULL;
+    }
+    
+    heap_lock_acquire();
+    
+    // grow in place by absorbing a free physical successor
+    if (aligned > block->size) {
+        block_header_t* next = next_block(block);
+        if (!next->is_free || block->size + BLOCK_OVERHEAD + next->size < aligned) {
+            // no room here: move
+            heap_lock_release();
+            void* new_ptr = kmalloc_at(size, site);
+            if (!new_ptr) {
+                return NULL;
+            }
+            memcpy(new_ptr, ptr, block->size);
+            heap_free(ptr);
+            return new_ptr;
+        }
+        
+        free_list_remove(next);
+        block->size += next->size + BLOCK_OVERHEAD;
+    }
+    
+    // give back whatever the block no longer needs
+    split_block(block, aligned);
+    set_footer(block);
+    
+    if (stats.used_memory > stats.peak_used_memory) {
+        stats.peak_used_memory = stats.used_memory;
+    }
+    heap_lock_release();
+    
+    memprof_resize(block, size);
+    return ptr;
+}
+
+void* krealloc(void* ptr, size_t size) {
+    uint32_t id = ktrace_id(ptr);
+    void* new_ptr = heap_realloc(ptr, size, MEMPROF_CALLER());
+    ktrace_realloc(ptr, new_ptr, id, size);
+    return new_ptr;
+}
+
 void kfree(void* ptr) {
+    ktrace_free(ptr);
+    heap_free(ptr);
+}
+
+static void heap_free(void* ptr) {
     if (!ptr || !memory_initialized) {
         return;
     }
@@ -96,51 +621,110 @@ void kfree(void* ptr) {
     block_header_t* block = (block_header_t*)((char*)ptr - BLOCK_HEADER_SIZE);
     
     // validate the block
-    if ((char*)block < heap_memory || 
-        (char*)block >= heap_memory + HEAP_SIZE ||
-        block->is_free) {
+    if (!find_arena(block) || block->is_free || (block->flags & BLOCK_CACHED)) {
         console_println("WARNING: Invalid free() call");
         return;
     }
     
-    // mark block as free
-    block->is_free = 1;
+    memprof_untrack(block);
+    
+    if (magazine_free(block)) {
+        return;
+    }
+    
+    // rather than wait for another hart's heap operation, queue the block
+    // for whoever holds the lock. magazine_free above may still have waited
+    // for heap_lock, to flush a full magazine or allocate an empty one.
+    if (!spin_trylock(&heap_lock)) {
+        block_header_t* head;
+        block->flags = BLOCK_CACHED;
+        do {
+            head = deferred_frees;
+            block->next_free = head;
+        } while (!__sync_bool_compare_and_swap(&deferred_frees, head, block));
+        __sync_fetch_and_add(&stats.deferred_frees, 1);
+        return;
+    }
+    
+    heap_drain_deferred();
+    heap_free_block(block);
+    heap_lock_release();
+}
+
+// return a used block to the free lists; caller holds heap_lock
+static void heap_free_block(block_header_t* block) {
+    arena_t* arena = find_arena(block);
     
-    // update statistics
-    stats.used_memory -= block->size + BLOCK_HEADER_SIZE;
-    stats.free_memory += block->size + BLOCK_HEADER_SIZE;
     stats.num_allocations--;
     
-    // merge adjacent free blocks
-    merge_free_blocks();
+    // mark block as free and merge it with its physical neighbours
+    block->is_free = 1;
+    block->flags = 0;
+    block = coalesce_block(block);
+    
+    // a page-backed arena that is entirely free goes back to the page allocator
+    if (arena->page_order >= 0 &&
+        block->size + BLOCK_OVERHEAD + ARENA_FENCE_SIZE == arena->size) {
+        arena_release(arena);
+        return;
+    }
+    
+    set_footer(block);
+    free_list_insert(block);
 }
 
 void memory_print_info(void) {
+    memory_stats_t current = memory_get_stats();
+    
     console_println("\n--- Memory Information ---");
     console_puts("Total memory: ");
-    console_put_hex(stats.total_memory);
+    console_put_hex(current.total_memory);
     console_puts(" bytes\n");
     
     console_puts("Used memory: ");
-    console_put_hex(stats.used_memory);
+    console_put_hex(current.used_memory);
     console_puts(" bytes\n");
     
     console_puts("Free memory: ");
-    console_put_hex(stats.free_memory);
+    console_put_hex(current.free_memory);
     console_puts(" bytes\n");
     
     console_puts("Active allocations: ");
-    console_put_hex(stats.num_allocations);
+    console_put_hex(current.num_allocations);
     console_puts("\n");
     
     console_puts("Free blocks: ");
-    console_put_hex(stats.num_free_blocks);
+    console_put_hex(current.num_free_blocks);
     console_puts("\n");
     
+    console_puts("Peak used memory: ");
+    console_put_hex(current.peak_used_memory);
+    console_puts(" bytes\n");
+    
+    console_puts("Heap arenas: ");
+    console_put_hex((unsigned int)num_arenas);
+    console_puts("\n");
+    
+    console_puts("Hart caches: ");
+    console_put_hex(current.cached_blocks);
+    console_puts(" blocks (");
+    console_put_hex(current.cached_memory);
+    console_puts(" bytes), ");
+    console_put_hex(current.deferred_frees);
+    console_puts(" deferred frees\n");
+    
+    console_puts("Aligned allocations: ");
+    console_put_hex(current.aligned_allocations);
+    console_puts(" (padding reclaimed ");
+    console_put_hex(current.align_padding_reclaimed);
+    console_puts(", wasted ");
+    console_put_hex(current.align_padding_wasted);
+    console_puts(" bytes)\n");
+    
     // show fragmentation info
     console_puts("Heap utilization: ");
-    if (stats.total_memory > 0) {
-        uint32_t utilization = (stats.used_memory * 100) / stats.total_memory;
+    if (current.total_memory > 0) {
+        uint32_t utilization = (current.used_memory * 100) / current.total_memory;
         console_put_hex(utilization);
         console_puts("%\n");
     } else {
@@ -148,68 +732,793 @@ void memory_print_info(void) {
     }
 }
 
-memory_stats_t memory_get_stats(void) {
-    // update free block count
-    stats.num_free_blocks = 0;
-    block_header_t* current = heap_start;
+// heap health detail for `mem -v`; reads counters only, never walks the heap
+void memory_print_details(void) {
+    memory_stats_t current = memory_get_stats();
+    
+    console_println("\n--- Heap Details ---");
+    console_puts("Largest free block: ");
+    console_put_hex(current.largest_free_block);
+    console_puts(" bytes\n");
+    
+    console_puts("External fragmentation: ");
+    console_put_hex(current.fragmentation);
+    console_puts("%\n");
+    
+    console_println("Size class   Free blocks  Allocations");
+    for (int cls = 0; cls < NUM_SIZE_CLASSES; cls++) {
+        size_t allocs = class_alloc_count(cls);
+        if (!class_free_blocks[cls] && !allocs) {
+            continue;
+        }
+        console_put_hex(size_class_base(cls));
+        console_puts((cls == NUM_SIZE_CLASSES - 1) ? "+ " : "  ");
+        console_put_hex(class_free_blocks[cls]);
+        console_puts("   ");
+        console_put_hex(allocs);
+        console_puts("\n");
+    }
+}
+
+#ifdef MEMPROF
+static memprof_site_t* memprof_lookup(void* site) {
+    uintptr_t key = (uintptr_t)site;
+    size_t index = ((key >> 1) * 0x9E3779B97F4A7C15UL) >> (64 - MEMPROF_SITES_SHIFT);
+    
+    for (int probe = 0; probe < MEMPROF_SITES; probe++) {
+        memprof_site_t* entry = &memprof_sites[(index + probe) & (MEMPROF_SITES - 1)];
+        if (entry->site == site) {
+            return entry;
+        }
+        if (!entry->site) {
+            entry->site = site;
+            return entry;
+        }
+    }
+    return &memprof_overflow;
+}
+
+static void memprof_track(block_header_t* block, void* site, size_t size) {
+    spin_lock(&debug_lock);
+    memprof_site_t* entry = memprof_lookup(site);
+    
+    block->alloc_site = site;
+    block->alloc_size = size;
+    block->alloc_time = heap_cycles();
+    
+    entry->live_bytes += size;
+    entry->live_blocks++;
+    entry->total_allocs++;
+    spin_unlock(&debug_lock);
+}
+
+static void memprof_untrack(block_header_t* block) {
+    spin_lock(&debug_lock);
+    memprof_site_t* entry = memprof_lookup(block->alloc_site);
+    
+    entry->live_bytes -= block->alloc_size;
+    entry->live_blocks--;
+    entry->total_frees++;
+    entry->total_lifetime += heap_cycles() - block->alloc_time;
+    spin_unlock(&debug_lock);
+}
+
+// in-place krealloc: the block stays charged to the site that created it
+static void memprof_resize(block_header_t* block, size_t size) {
+    spin_lock(&debug_lock);
+    memprof_site_t* entry = memprof_lookup(block->alloc_site);
+    
+    entry->live_bytes = entry->live_bytes - block->alloc_size + size;
+    block->alloc_size = size;
+    spin_unlock(&debug_lock);
+}
+
+static void memprof_print_site(const memprof_site_t* entry) {
+    if (entry->site) {
+        console_put_hex((uintptr_t)entry->site);
+    } else {
+        console_puts("(other)");
+    }
+    console_puts("  ");
+    console_put_hex(entry->live_bytes);
+    console_puts("  ");
+    console_put_hex(entry->live_blocks);
+    console_puts("  ");
+    console_put_hex(entry->total_allocs);
+    console_puts("  ");
+    console_put_hex(entry->total_frees ? entry->total_lifetime / entry->total_frees : 0);
+    console_puts("\n");
+}
+
+// list the call sites holding the most live heap bytes
+void memprof_print(int max_sites) {
+    bool shown[MEMPROF_SITES] = {false};
+    
+    console_println("\n--- Allocation Sites (by live bytes) ---");
+    console_println("Site  Live bytes  Live blocks  Allocs  Avg lifetime (cycles)");
+    
+    for (int n = 0; n < max_sites; n++) {
+        int best = -1;
+        for (int i = 0; i < MEMPROF_SITES; i++) {
+            if (!memprof_sites[i].site || shown[i]) {
+                continue;
+            }
+            if (best < 0 || memprof_sites[i].live_bytes > memprof_sites[best].live_bytes) {
+                best = i;
+            }
+        }
+        if (best < 0) {
+            break;
+        }
+        shown[best] = true;
+        memprof_print_site(&memprof_sites[best]);
+    }
+    
+    if (memprof_overflow.total_allocs) {
+        memprof_print_site(&memprof_overflow);
+    }
+}
+#else
+void memprof_print(int max_sites __attribute__((unused))) {
+    console_println("memprof: kernel built without MEMPROF=1");
+}
+#endif
+
+#ifdef KMALLOC_TRACE
+static void ktrace_record(char op, uint32_t id, size_t size, size_t align) {
+    spin_lock(&debug_lock);
+    ktrace_entry_t* entry = &ktrace_ring[ktrace_head & (KTRACE_ENTRIES - 1)];
+    
+    entry->cycles = heap_cycles();
+    entry->id = id;
+    entry->size = (uint32_t)size;
+    entry->align = (uint32_t)align;
+    entry->op = op;
+    ktrace_head++;
+    spin_unlock(&debug_lock);
+}
+
+static void ktrace_alloc(void* ptr, char op, size_t size, size_t align) {
+    if (!ptr) {
+        return;
+    }
+    
+    block_header_t* block = (block_header_t*)((char*)ptr - BLOCK_HEADER_SIZE);
+    block->trace_id = __sync_add_and_fetch(&ktrace_next_id, 1);
+    ktrace_record(op, block->trace_id, size, align);
+}
+
+// only frees that heap_free will accept are recorded
+static void ktrace_free(void* ptr) {
+    if (!ptr || !memory_initialized) {
+        return;
+    }
+    
+    block_header_t* block = (block_header_t*)((char*)ptr - BLOCK_HEADER_SIZE);
+    if (find_arena(block) && !block->is_free && !(block->flags & BLOCK_CACHED)) {
+        ktrace_record('F', block->trace_id, 0, 0);
+    }
+}
+
+static uint32_t ktrace_id(void* ptr) {
+    if (!ptr) {
+        return 0;
+    }
+    return ((block_header_t*)((char*)ptr - BLOCK_HEADER_SIZE))->trace_id;
+}
+
+// a moved block keeps its id so the replay sees one realloc, not alloc+free
+static void ktrace_realloc(void* old_ptr, void* new_ptr, uint32_t id, size_t size) {
+    if (!old_ptr) {
+        ktrace_alloc(new_ptr, 'A', size, 8);
+    } else if (size == 0) {
+        ktrace_record('F', id, 0, 0);
+    } else if (new_ptr) {
+        ((block_header_t*)((char*)new_ptr - BLOCK_HEADER_SIZE))->trace_id = id;
+        ktrace_record('R', id, size, 8);
+    }
+}
+
+// one event per line between begin/end markers; the cycle column is the
+// delta from the previous event, which keeps it short in the fixed-width
+// hex columns kmalloc_replay parses
+void ktrace_dump(void) {
+    uint64_t first = 0;
+    if (ktrace_head > KTRACE_ENTRIES) {
+        first = ktrace_head - KTRACE_ENTRIES;
+    }
+    
+    console_printf("ktrace begin 0x%08lX dropped 0x%08lX\n",
+                   (unsigned long)(ktrace_head - first), (unsigned long)first);
+    
+    uint64_t prev_cycles = 0;
+    for (uint64_t i = first; i < ktrace_head; i++) {
+        ktrace_entry_t* entry = &ktrace_ring[i & (KTRACE_ENTRIES - 1)];
+        uint64_t delta = (i == first) ? 0 : entry->cycles - prev_cycles;
+        prev_cycles = entry->cycles;
+        
+        console_printf("%c 0x%08lX 0x%08lX 0x%08lX 0x%08lX\n", entry->op,
+                       (unsigned long)entry->id, (unsigned long)entry->size,
+                       (unsigned long)entry->align, (unsigned long)delta);
+    }
     
-    while (current) {
-        if (current->is_free) {
-            stats.num_free_blocks++;
+    console_println("ktrace end");
+}
+
+void ktrace_clear(void) {
+    ktrace_head = 0;
+}
+#else
+void ktrace_dump(void) {
+    console_println("ktrace: kernel built without KTRACE=1");
+}
+
+void ktrace_clear(void) {
+}
+#endif
+
+// blocks sitting in magazines and the depot; the hart caches are read
+// without their owners' cooperation, so this is a snapshot
+static void cached_totals(size_t* blocks, size_t* bytes) {
+    *blocks = depot_cached_blocks;
+    *bytes = depot_cached_bytes;
+    for (int hart = 0; hart < MAX_HARTS; hart++) {
+        for (int cls = 0; cls < MAGAZINE_CLASSES; cls++) {
+            hart_cache_t* cache = &hart_caches[hart][cls];
+            if (cache->loaded) {
+                *blocks += cache->loaded->rounds;
+                *bytes += cache->loaded->bytes;
+            }
+            if (cache->previous) {
+                *blocks += cache->previous->rounds;
+                *bytes += cache->previous->bytes;
+            }
+        }
+    }
+}
+
+static size_t class_alloc_count(int cls) {
+    size_t count = class_allocs[cls];
+    if (cls < NUM_SMALL_CLASSES) {
+        for (int hart = 0; hart < MAX_HARTS; hart++) {
+            count += hart_class_allocs[hart][cls];
         }
-        current = current->next;
     }
+    return count;
+}
+
+// cached blocks are neither in use nor on the free lists: they come out of
+// used_memory and the allocation count, and count as free space when
+// measuring fragmentation
+memory_stats_t memory_get_stats(void) {
+    heap_lock_acquire();
+    
+    memory_stats_t current = stats;
+    cached_totals(&current.cached_blocks, &current.cached_memory);
+    current.used_memory -= current.cached_memory;
+    current.num_allocations -= current.cached_blocks + num_magazines;
     
-    return stats;
+    // share of free memory outside the largest free block
+    current.largest_free_block = largest_free_block();
+    current.fragmentation = 0;
+    size_t free_memory = current.free_memory + current.cached_memory;
+    if (free_memory > 0 && current.largest_free_block > 0) {
+        size_t largest_span = current.largest_free_block + BLOCK_OVERHEAD;
+        current.fragmentation = 100 - (largest_span * 100) / free_memory;
+    }
+    
+    heap_lock_release();
+    return current;
 }
 
 // internal helper functions
+
+// index of the highest set bit; avoids libgcc helpers for __builtin_clz
+static inline int highest_bit(uint64_t x) {
+    int n = 0;
+    if (x >> 32) { n += 32; x >>= 32; }
+    if (x >> 16) { n += 16; x >>= 16; }
+    if (x >> 8)  { n += 8;  x >>= 8; }
+    if (x >> 4)  { n += 4;  x >>= 4; }
+    if (x >> 2)  { n += 2;  x >>= 2; }
+    if (x >> 1)  { n += 1; }
+    return n;
+}
+
+static inline int lowest_bit(uint64_t x) {
+    return highest_bit(x & -x);
+}
+
+static int size_class(size_t size) {
+    if (size < SMALL_CLASS_LIMIT) {
+        return size >> SMALL_CLASS_SHIFT;
+    }
+    
+    int fl = highest_bit(size);
+    int sl = (size >> (fl - SUBCLASS_BITS)) & (SUBCLASSES - 1);
+    int cls = NUM_SMALL_CLASSES + ((fl - SMALL_CLASS_LIMIT_SHIFT) << SUBCLASS_BITS) + sl;
+    
+    return (cls < NUM_SIZE_CLASSES) ? cls : NUM_SIZE_CLASSES - 1;
+}
+
+// smallest block size that maps to the given class
+static size_t size_class_base(int cls) {
+    if (cls < NUM_SMALL_CLASSES) {
+        return (size_t)cls << SMALL_CLASS_SHIFT;
+    }
+    
+    int fl = SMALL_CLASS_LIMIT_SHIFT + ((cls - NUM_SMALL_CLASSES) >> SUBCLASS_BITS);
+    int sl = (cls - NUM_SMALL_CLASSES) & (SUBCLASSES - 1);
+    return ((size_t)1 << fl) + ((size_t)sl << (fl - SUBCLASS_BITS));
+}
+
+static void free_list_insert(block_header_t* block) {
+    int cls = size_class(block->size);
+    
+    block->prev_free = NULL;
+    block->next_free = free_lists[cls];
+    if (free_lists[cls]) {
+        free_lists[cls]->prev_free = block;
+    }
+    free_lists[cls] = block;
+    free_class_bitmap |= (uint64_t)1 << cls;
+    class_free_blocks[cls]++;
+    
+    stats.num_free_blocks++;
+    stats.free_memory += block->size + BLOCK_OVERHEAD;
+    stats.used_memory -= block->size + BLOCK_OVERHEAD;
+}
+
+static void free_list_remove(block_header_t* block) {
+    int cls = size_class(block->size);
+    
+    if (block->prev_free) {
+        block->prev_free->next_free = block->next_free;
+    } else {
+        free_lists[cls] = block->next_free;
+    }
+    if (block->next_free) {
+        block->next_free->prev_free = block->prev_free;
+    }
+    
+    if (!free_lists[cls]) {
+        free_class_bitmap &= ~((uint64_t)1 << cls);
+    }
+    block->next_free = NULL;
+    block->prev_free = NULL;
+    class_free_blocks[cls]--;
+    
+    stats.num_free_blocks--;
+    stats.free_memory -= block->size + BLOCK_OVERHEAD;
+    stats.used_memory += block->size + BLOCK_OVERHEAD;
+}
+
+// a fresh magazine comes off the static arena and is never returned
+static magazine_t* magazine_new(void) {
+    heap_lock_acquire();
+    block_header_t* block = heap_alloc(sizeof(magazine_t), 0);
+    if (block && !in_static_arena(block)) {
+        heap_free_block(block);
+        block = NULL;
+    }
+    if (block) {
+        // allocator metadata, not a caller's allocation
+        class_allocs[size_class(sizeof(magazine_t))]--;
+        num_magazines++;
+    }
+    heap_lock_release();
+    if (!block) {
+        return NULL;
+    }
+    
+    block->flags = 0;
+    magazine_t* magazine = (magazine_t*)((char*)block + BLOCK_HEADER_SIZE);
+    magazine->next = NULL;
+    magazine->rounds = 0;
+    magazine->bytes = 0;
+    return magazine;
+}
+
+// hand every block in the magazine back to the size-class lists at once
+static void magazine_flush(magazine_t* magazine) {
+    heap_lock_acquire();
+    for (int i = 0; i < magazine->rounds; i++) {
+        heap_free_block(magazine->blocks[i]);
+    }
+    heap_lock_release();
+    magazine->rounds = 0;
+    magazine->bytes = 0;
+}
+
+// flush every full magazine parked in the depot; caller holds heap_lock,
+// which may be taken before depot_lock but never after it
+static int depot_reclaim(void) {
+    int flushed = 0;
+    if (!depot_cached_blocks) {
+        return 0;
+    }
+    
+    spin_lock(&depot_lock);
+    for (int cls = 0; cls < MAGAZINE_CLASSES; cls++) {
+        depot_t* depot = &depots[cls];
+        while (depot->full) {
+            magazine_t* magazine = depot->full;
+            depot->full = magazine->next;
+            depot->num_full--;
+            depot_cached_blocks -= magazine->rounds;
+            depot_cached_bytes -= magazine->bytes;
+            
+            for (int i = 0; i < magazine->rounds; i++) {
+                heap_free_block(magazine->blocks[i]);
+            }
+            flushed += magazine->rounds;
+            magazine->rounds = 0;
+            magazine->bytes = 0;
+            
+            magazine->next = depot->empty;
+            depot->empty = magazine;
+        }
+    }
+    spin_unlock(&depot_lock);
+    
+    return flushed;
+}
+
+// empty this hart's magazines back into the heap before it grows; never
+// called from inside a magazine operation
+static void magazine_reap(unsigned int hart) {
+    if (hart >= MAX_HARTS || !hart_cached_blocks[hart]) {
+        return;
+    }
+    
+    for (int cls = 0; cls < MAGAZINE_CLASSES; cls++) {
+        hart_cache_t* cache = &hart_caches[hart][cls];
+        if (cache->loaded && cache->loaded->rounds) {
+            hart_cached_blocks[hart] -= cache->loaded->rounds;
+            magazine_flush(cache->loaded);
+        }
+        if (cache->previous && cache->previous->rounds) {
+            hart_cached_blocks[hart] -= cache->previous->rounds;
+            magazine_flush(cache->previous);
+        }
+    }
+}
+
+// loaded and previous are both empty: swap in a full magazine from the
+// depot, or fill loaded with a batch from the heap
+static int magazine_reload(hart_cache_t* cache, int cls, unsigned int hart) {
+    depot_t* depot = &depots[cls];
+    
+    spin_lock(&depot_lock);
+    if (depot->full) {
+        magazine_t* full = depot->full;
+        depot->full = full->next;
+        depot->num_full--;
+        depot_cached_blocks -= full->rounds;
+        depot_cached_bytes -= full->bytes;
+        
+        if (cache->loaded) {
+            cache->loaded->next = depot->empty;
+            depot->empty = cache->loaded;
+        }
+        cache->loaded = full;
+        spin_unlock(&depot_lock);
+        
+        hart_cached_blocks[hart] += full->rounds;
+        return 1;
+    }
+    spin_unlock(&depot_lock);
+    
+    if (!cache->loaded) {
+        cache->loaded = magazine_new();
+        if (!cache->loaded) {
+            return 0;
+        }
+    }
+    
+    // a refill is not an allocation; the blocks are counted when
+    // magazine_alloc hands them out
+    magazine_t* magazine = cache->loaded;
+    heap_lock_acquire();
+    while (magazine->rounds < MAGAZINE_REFILL) {
+        block_header_t* block = heap_alloc((size_t)cls << SMALL_CLASS_SHIFT, 0);
+        if (block && !in_static_arena(block)) {
+            heap_free_block(block);
+            block = NULL;
+        }
+        if (!block) {
+            break;
+        }
+        class_allocs[cls]--;
+        block->flags = BLOCK_CACHED;
+        magazine->blocks[magazine->rounds++] = block;
+        magazine->bytes += block->size + BLOCK_OVERHEAD;
+    }
+    heap_lock_release();
+    
+    hart_cached_blocks[hart] += magazine->rounds;
+    return magazine->rounds > 0;
+}
+
+// loaded and previous are both full: park loaded in the depot and continue
+// with an empty magazine; when the depot already holds enough, flush instead
+static int magazine_unload(hart_cache_t* cache, int cls, unsigned int hart) {
+    depot_t* depot = &depots[cls];
+    magazine_t* magazine = cache->loaded;
+    
+    spin_lock(&depot_lock);
+    if (magazine && depot->num_full < DEPOT_MAX_FULL) {
+        magazine->next = depot->full;
+        depot->full = magazine;
+        depot->num_full++;
+        depot_cached_blocks += magazine->rounds;
+        depot_cached_bytes += magazine->bytes;
+        hart_cached_blocks[hart] -= magazine->rounds;
+        magazine = NULL;
+    }
+    if (!magazine && depot->empty) {
+        magazine = depot->empty;
+        depot->empty = magazine->next;
+    }
+    spin_unlock(&depot_lock);
+    
+    if (magazine && magazine->rounds) {
+        hart_cached_blocks[hart] -= magazine->rounds;
+        magazine_flush(magazine);
+    }
+    if (!magazine) {
+        magazine = magazine_new();
+    }
+    
+    cache->loaded = magazine;
+    return magazine != NULL;
+}
+
+// serve a small request from this hart's magazines; NULL sends the caller
+// to the heap
+static block_header_t* magazine_alloc(size_t size) {
+    unsigned int hart = current_hart();
+    if (hart >= MAX_HARTS || size == 0 || !memory_initialized) {
+        return NULL;
+    }
+    
+    size = block_size_for(size);
+    if (!size) {
+        return NULL;
+    }
+    
+    int cls = (size + (1 << SMALL_CLASS_SHIFT) - 1) >> SMALL_CLASS_SHIFT;
+    if (cls >= MAGAZINE_CLASSES) {
+        return NULL;
+    }
+    
+    hart_cache_t* cache = &hart_caches[hart][cls];
+    if (!cache->loaded || cache->loaded->rounds == 0) {
+        if (cache->previous && cache->previous->rounds > 0) {
+            magazine_t* swap = cache->loaded;
+            cache->loaded = cache->previous;
+            cache->previous = swap;
+        } else if (!magazine_reload(cache, cls, hart)) {
+            return NULL;
+        }
+    }
+    
+    block_header_t* block = cache->loaded->blocks[--cache->loaded->rounds];
+    cache->loaded->bytes -= block->size + BLOCK_OVERHEAD;
+    hart_cached_blocks[hart]--;
+    hart_class_allocs[hart][size_class(size)]++;
+    return block;
+}
+
+// keep a freed small block on this hart; 0 sends the caller to the heap
+static int magazine_free(block_header_t* block) {
+    unsigned int hart = current_hart();
+    int cls = block->size >> SMALL_CLASS_SHIFT;
+    if (hart >= MAX_HARTS || cls >= MAGAZINE_CLASSES || !in_static_arena(block)) {
+        return 0;
+    }
+    
+    hart_cache_t* cache = &hart_caches[hart][cls];
+    if (!cache->loaded || cache->loaded->rounds == MAGAZINE_ROUNDS) {
+        if (!cache->previous || cache->previous->rounds < MAGAZINE_ROUNDS) {
+            magazine_t* swap = cache->loaded;
+            cache->loaded = cache->previous;
+            cache->previous = swap;
+        }
+        if (!cache->loaded || cache->loaded->rounds == MAGAZINE_ROUNDS) {
+            if (!magazine_unload(cache, cls, hart)) {
+                return 0;
+            }
+        }
+    }
+    
+    block->flags = BLOCK_CACHED;
+    cache->loaded->blocks[cache->loaded->rounds++] = block;
+    cache->loaded->bytes += block->size + BLOCK_OVERHEAD;
+    hart_cached_blocks[hart]++;
+    return 1;
+}
+
+// not tracked incrementally: computed on demand by scanning the highest
+// non-empty class, which holds the biggest block. That walk is linear in
+// the length of one list, so memory_get_stats is not O(1)
+static size_t largest_free_block(void) {
+    if (!free_class_bitmap) {
+        return 0;
+    }
+    
+    size_t largest = 0;
+    for (block_header_t* block = free_lists[highest_bit(free_class_bitmap)]; block; block = block->next_free) {
+        if (block->size > largest) {
+            largest = block->size;
+        }
+    }
+    return largest;
+}
+
 static block_header_t* find_free_block(size_t size) {
-    block_header_t* current = heap_start;
+    int cls = size_class(size);
+    block_header_t* block;
     
-    while (current) {
-        if (current->is_free && current->size >= size) {
-            return current;
+    // every block in the request's class fits when the request sits at the
+    // bottom of that class (the open-ended last class has no such guarantee)
+    if (free_lists[cls] && size == size_class_base(cls) && cls < NUM_SIZE_CLASSES - 1) {
+        block = free_lists[cls];
+        free_list_remove(block);
+        return block;
+    }
+    
+    // any block in a larger non-empty class fits; take the smallest such class
+    uint64_t larger = (cls < NUM_SIZE_CLASSES - 1)
+        ? free_class_bitmap & (~(uint64_t)0 << (cls + 1))
+        : 0;
+    if (larger) {
+        block = free_lists[lowest_bit(larger)];
+        free_list_remove(block);
+        return block;
+    }
+    
+    // last resort: first fit within the request's own class
+    for (block = free_lists[cls]; block; block = block->next_free) {
+        if (block->size >= size) {
+            free_list_remove(block);
+            return block;
         }
-        current = current->next;
     }
     
     return NULL;
 }
 
+// shrink a block (not on any free list) to size bytes, returning the tail
+// to the free lists; the caller rewrites the block's own footer
 static void split_block(block_header_t* block, size_t size) {
-    if (block->size <= size + BLOCK_HEADER_SIZE + MIN_BLOCK_SIZE) {
+    if (block->size <= size + BLOCK_OVERHEAD + MIN_BLOCK_SIZE) {
         // block is too small to split
         return;
     }
     
-    // create new block for the remaining space
-    block_header_t* new_block = (block_header_t*)((char*)block + BLOCK_HEADER_SIZE + size);
-    new_block->size = block->size - size - BLOCK_HEADER_SIZE;
+    // create new block for the remaining space; it inherits the zeroed
+    // state, since its payload lies inside the old payload
+    block_header_t* new_block = (block_header_t*)((char*)block + BLOCK_OVERHEAD + size);
+    new_block->size = block->size - size - BLOCK_OVERHEAD;
     new_block->is_free = 1;
-    new_block->next = block->next;
+    new_block->flags = block->flags;
+    
+    // a shrinking krealloc can leave the tail next to a free block
+    block_header_t* next = next_block(new_block);
+    if (next->is_free) {
+        free_list_remove(next);
+        new_block->size += next->size + BLOCK_OVERHEAD;
+        new_block->flags = 0;
+    }
+    
+    set_footer(new_block);
+    free_list_insert(new_block);
     
     // update current block
     block->size = size;
-    block->next = new_block;
 }
 
-static void merge_free_blocks(void) {
-    block_header_t* current = heap_start;
+// merge a newly freed block (not on any free list) with free physical
+// neighbours found through the boundary tags; returns the merged block
+static block_header_t* coalesce_block(block_header_t* block) {
+    block_header_t* next = next_block(block);
+    if (next->is_free) {
+        free_list_remove(next);
+        block->size += next->size + BLOCK_OVERHEAD;
+    }
     
-    while (current && current->next) {
-        if (current->is_free && current->next->is_free) {
-            // check if blocks are adjacent
-            char* current_end = (char*)current + BLOCK_HEADER_SIZE + current->size;
-            char* next_start = (char*)current->next;
-            
-            if (current_end == next_start) {
-                // merge the blocks
-                current->size += BLOCK_HEADER_SIZE + current->next->size;
-                current->next = current->next->next;
-                continue; // don't advance current, check for more merges
-            }
+    block_footer_t* prev_footer = (block_footer_t*)block - 1;
+    if (prev_footer->size_and_free & FOOTER_FREE) {
+        size_t prev_size = prev_footer->size_and_free & ~(size_t)FOOTER_FREE;
+        block_header_t* prev = (block_header_t*)((char*)prev_footer - prev_size - BLOCK_HEADER_SIZE);
+        free_list_remove(prev);
+        prev->size += block->size + BLOCK_OVERHEAD;
+        prev->flags = 0;
+        block = prev;
+    }
+    
+    return block;
+}
+
+// turn [start, start + size) into an arena holding one free block; the
+// arena is bracketed by an allocated prologue footer and an allocated
+// zero-size epilogue header, so coalescing never runs off either end
+static int arena_add(char* start, size_t size, int page_order) {
+    int slot = 0;
+    while (slot < num_arena_slots && arenas[slot].start) {
+        slot++;
+    }
+    if (slot >= MAX_ARENAS) {
+        return -1;
+    }
+    
+    block_footer_t* prologue = (block_footer_t*)start;
+    prologue->size_and_free = 0;
+    
+    // the static arena lives in BSS, which boot.s clears; pages are not zeroed
+    block_header_t* first = (block_header_t*)(start + BLOCK_FOOTER_SIZE);
+    first->size = size - ARENA_FENCE_SIZE - BLOCK_OVERHEAD;
+    first->is_free = 1;
+    first->flags = (page_order < 0) ? BLOCK_ZEROED : 0;
+    set_footer(first);
+    
+    block_header_t* epilogue = next_block(first);
+    epilogue->size = 0;
+    epilogue->is_free = 0;
+    epilogue->flags = 0;
+    
+    arenas[slot].start = start;
+    arenas[slot].size = size;
+    arenas[slot].page_order = page_order;
+    if (slot == num_arena_slots) {
+        num_arena_slots++;
+    }
+    num_arenas++;
+    if (page_order >= 0) {
+        arena_map(&arenas[slot], (uint8_t)(slot + 1));
+    }
+    
+    stats.total_memory += size;
+    stats.used_memory += size;
+    free_list_insert(first);
+    return 0;
+}
+
+// add a page-backed arena that holds a size-byte block. Each arena is
+// twice the size of the one before (1MB, 2MB, 4MB, ...), so a few arena
+// slots reach all of RAM; when no block that big is left, take the
+// largest one that still fits the request
+static int heap_grow(size_t size) {
+    size_t needed = size + BLOCK_OVERHEAD + ARENA_FENCE_SIZE;
+    unsigned int min_order = page_order_for_size(needed);
+    if ((PAGE_SIZE << min_order) < needed || num_arenas >= MAX_ARENAS) {
+        return -1;
+    }
+    if (min_order < ARENA_MIN_ORDER) {
+        min_order = ARENA_MIN_ORDER;
+    }
+    
+    // num_arenas counts the static arena
+    unsigned int order = ARENA_GROW_ORDER + num_arenas - 1;
+    if (order > PAGE_MAX_ORDER) {
+        order = PAGE_MAX_ORDER;
+    }
+    if (order < min_order) {
+        order = min_order;
+    }
+    
+    char* pages;
+    while (!(pages = (char*)alloc_pages(order))) {
+        if (order == min_order) {
+            return -1;
         }
-        current = current->next;
+        order--;
+    }
+    
+    if (arena_add(pages, PAGE_SIZE << order, order) != 0) {
+        free_pages(pages, order);
+        return -1;
     }
+    return 0;
 }
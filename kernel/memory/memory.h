@@ -3,26 +3,64 @@
 
 #include "../include/types.h"
 
+#define CACHE_LINE_SIZE 64
+
+// kmalloc_flags flags
+#define KMALLOC_CACHE_ALIGNED 0x1   // start the block on a cache line
+
 typedef struct {
     size_t total_memory;
     size_t used_memory;
     size_t free_memory;
     size_t num_allocations;
     size_t num_free_blocks;
+    size_t peak_used_memory;         // high-water mark, magazine caches included
+    size_t largest_free_block;       // payload bytes of the biggest free block (scanned)
+    size_t fragmentation;            // external fragmentation index, percent
+    size_t aligned_allocations;
+    size_t align_padding_reclaimed;  // leading padding returned to the free lists
+    size_t align_padding_wasted;     // slack left inside aligned blocks
+    size_t cached_blocks;            // held in per-hart magazines and the depot
+    size_t cached_memory;            // their bytes; not in used or free memory
+    size_t deferred_frees;           // frees queued while the heap lock was busy
 } memory_stats_t;
 
 // memory block header for allocator
 typedef struct block_header {
-    size_t size;
+    size_t size;                     // payload size, excluding header and footer
     int is_free;
-    struct block_header* next;
+    int flags;                       // BLOCK_* flags
+    struct block_header* next_free;  // size-class free list links (free blocks only)
+    struct block_header* prev_free;
+#ifdef MEMPROF
+    void* alloc_site;                // return address of the allocating call
+    size_t alloc_size;               // size the caller asked for
+    uint64_t alloc_time;             // mcycle at allocation
+#endif
+#ifdef KMALLOC_TRACE
+    uint32_t trace_id;               // allocation id in the kmalloc trace
+#endif
 } block_header_t;
 
+// boundary tag at the end of every block: payload size with the free bit
+// in bit 0, so a block can find and merge with its physical predecessor
+typedef struct {
+    size_t size_and_free;
+} block_footer_t;
+
 // public API
 void memory_init(void);
 void* kmalloc(size_t size);
+void* kcalloc(size_t count, size_t size);
+void* krealloc(void* ptr, size_t size);   // keeps only 8-byte alignment on a move
+void* kmalloc_aligned(size_t size, size_t align);
+void* kmalloc_flags(size_t size, unsigned int flags);
 void kfree(void* ptr);
 void memory_print_info(void);
+void memory_print_details(void);
 memory_stats_t memory_get_stats(void);
+void memprof_print(int max_sites);
+void ktrace_dump(void);
+void ktrace_clear(void);
 
 #endif
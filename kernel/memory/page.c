@@ -0,0 +1,192 @@
+#include "page.h"
+#include "../drivers/console.h"
+#include "../include/kernel.h"
+
+// per-frame state: the head frame of a free block records its order
+#define FRAME_FREE 0x80
+#define FRAME_ORDER_MASK 0x7F
+
+// free blocks are linked through their own first bytes
+typedef struct free_block {
+    struct free_block* next;
+    struct free_block* prev;
+} free_block_t;
+
+// provided by boot/linker.ld
+extern char kernel_end[], ram_end[];
+
+static uintptr_t frames_base = 0;
+static size_t num_frames = 0;
+static uint8_t frame_state[PAGE_MAX_FRAMES];
+
+static free_block_t* free_areas[PAGE_MAX_ORDER + 1];
+static size_t free_area_count[PAGE_MAX_ORDER + 1];
+static size_t free_frames = 0;
+
+static inline size_t frame_index(void* addr) {
+    return ((uintptr_t)addr - frames_base) >> PAGE_SHIFT;
+}
+
+static inline free_block_t* frame_addr(size_t index) {
+    return (free_block_t*)(frames_base + (index << PAGE_SHIFT));
+}
+
+static void free_area_push(size_t index, unsigned int order) {
+    free_block_t* block = frame_addr(index);
+    
+    block->prev = NULL;
+    block->next = free_areas[order];
+    if (free_areas[order]) {
+        free_areas[order]->prev = block;
+    }
+    free_areas[order] = block;
+    free_area_count[order]++;
+    
+    frame_state[index] = FRAME_FREE | order;
+    free_frames += (size_t)1 << order;
+}
+
+static void free_area_remove(size_t index, unsigned int order) {
+    free_block_t* block = frame_addr(index);
+    
+    if (block->prev) {
+        block->prev->next = block->next;
+    } else {
+        free_areas[order] = block->next;
+    }
+    if (block->next) {
+        block->next->prev = block->prev;
+    }
+    free_area_count[order]--;
+    
+    frame_state[index] = 0;
+    free_frames -= (size_t)1 << order;
+}
+
+void page_init(void) {
+    uintptr_t start = ALIGN_UP((uintptr_t)kernel_end, PAGE_SIZE);
+    uintptr_t end = ALIGN_DOWN((uintptr_t)ram_end, PAGE_SIZE);
+    
+    frames_base = start;
+    num_frames = (end > start) ? (end - start) >> PAGE_SHIFT : 0;
+    if (num_frames > PAGE_MAX_FRAMES) {
+        num_frames = PAGE_MAX_FRAMES;
+    }
+    
+    // seed the free areas with the largest naturally aligned blocks that fit
+    size_t index = 0;
+    while (index < num_frames) {
+        unsigned int order = PAGE_MAX_ORDER;
+        while (order > 0 &&
+               ((index & (((size_t)1 << order) - 1)) != 0 ||
+                index + ((size_t)1 << order) > num_frames)) {
+            order--;
+        }
+        free_area_push(index, order);
+        index += (size_t)1 << order;
+    }
+    
+    console_puts("Page allocator initialized with ");
+    console_put_hex(num_frames);
+    console_puts(" frames at ");
+    console_put_hex(frames_base);
+    console_puts("\n");
+}
+
+void* alloc_pages(unsigned int order) {
+    if (order > PAGE_MAX_ORDER) {
+        return NULL;
+    }
+    
+    unsigned int current = order;
+    while (current <= PAGE_MAX_ORDER && !free_areas[current]) {
+        current++;
+    }
+    if (current > PAGE_MAX_ORDER) {
+        return NULL;
+    }
+    
+    size_t index = frame_index(free_areas[current]);
+    free_area_remove(index, current);
+    
+    // split down, returning the upper halves to the free areas
+    while (current > order) {
+        current--;
+        free_area_push(index + ((size_t)1 << current), current);
+    }
+    
+    return frame_addr(index);
+}
+
+void free_pages(void* addr, unsigned int order) {
+    if (!addr || order > PAGE_MAX_ORDER ||
+        (uintptr_t)addr < frames_base ||
+        ((uintptr_t)addr & (PAGE_SIZE - 1))) {
+        return;
+    }
+    
+    size_t index = frame_index(addr);
+    if (index + ((size_t)1 << order) > num_frames) {
+        return;
+    }
+    
+    // merge with the buddy for as long as it is free at the same order
+    while (order < PAGE_MAX_ORDER) {
+        size_t buddy = index ^ ((size_t)1 << order);
+        if (buddy + ((size_t)1 << order) > num_frames ||
+            frame_state[buddy] != (FRAME_FREE | order)) {
+            break;
+        }
+        free_area_remove(buddy, order);
+        if (buddy < index) {
+            index = buddy;
+        }
+        order++;
+    }
+    
+    free_area_push(index, order);
+}
+
+// frame index of addr, counted from the first frame alloc_pages manages
+size_t page_frame_number(const void* addr) {
+    if ((uintptr_t)addr < frames_base) {
+        return PAGE_MAX_FRAMES;
+    }
+    size_t index = frame_index((void*)addr);
+    return (index < num_frames) ? index : PAGE_MAX_FRAMES;
+}
+
+// smallest order whose block holds size bytes
+unsigned int page_order_for_size(size_t size) {
+    unsigned int order = 0;
+    while (order < PAGE_MAX_ORDER && (PAGE_SIZE << order) < size) {
+        order++;
+    }
+    return order;
+}
+
+size_t page_free_count(void) {
+    return free_frames;
+}
+
+void page_print_info(void) {
+    console_println("\n--- Page Frames ---");
+    console_puts("Total frames: ");
+    console_put_hex(num_frames);
+    console_puts("\n");
+    
+    console_puts("Free frames: ");
+    console_put_hex(free_frames);
+    console_puts("\n");
+    
+    console_puts("Free blocks by order:");
+    for (unsigned int order = 0; order <= PAGE_MAX_ORDER; order++) {
+        if (free_area_count[order]) {
+            console_puts(" ");
+            console_put_hex(order);
+            console_puts(":");
+            console_put_hex(free_area_count[order]);
+        }
+    }
+    console_puts("\n");
+}
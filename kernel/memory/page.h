@@ -0,0 +1,20 @@
+#ifndef PAGE_H
+#define PAGE_H
+
+#include "../include/types.h"
+
+#define PAGE_SHIFT 12
+#define PAGE_SIZE (1UL << PAGE_SHIFT)
+#define PAGE_MAX_ORDER 14                    // largest block: 64MB
+#define PAGE_MAX_FRAMES ((128UL * 1024 * 1024) >> PAGE_SHIFT)
+
+// public API
+void page_init(void);
+void* alloc_pages(unsigned int order);
+void free_pages(void* addr, unsigned int order);
+size_t page_frame_number(const void* addr);   // PAGE_MAX_FRAMES if not a managed frame
+unsigned int page_order_for_size(size_t size);
+size_t page_free_count(void);
+void page_print_info(void);
+
+#endif
@@ -0,0 +1,55 @@
+#include "scratch.h"
+#include "page.h"
+#include "../drivers/console.h"
+#include "../include/kernel.h"
+
+#define SCRATCH_ALIGN 16
+
+static char* scratch_base = NULL;
+static size_t scratch_size = 0;
+static size_t scratch_top = 0;
+static size_t scratch_peak = 0;
+
+void scratch_init(void) {
+    scratch_base = (char*)alloc_pages(SCRATCH_ORDER);
+    scratch_size = scratch_base ? (PAGE_SIZE << SCRATCH_ORDER) : 0;
+    scratch_top = 0;
+}
+
+void* scratch_alloc(size_t size) {
+    size_t start = ALIGN_UP(scratch_top, SCRATCH_ALIGN);
+    if (!scratch_base || size > scratch_size || start > scratch_size - size) {
+        return NULL;
+    }
+    
+    scratch_top = start + size;
+    if (scratch_top > scratch_peak) {
+        scratch_peak = scratch_top;
+    }
+    return scratch_base + start;
+}
+
+size_t scratch_mark(void) {
+    return scratch_top;
+}
+
+void scratch_release(size_t mark) {
+    if (mark <= scratch_top) {
+        scratch_top = mark;
+    }
+}
+
+void scratch_reset(void) {
+    scratch_top = 0;
+}
+
+void scratch_print_info(void) {
+    console_println("\n--- Scratch Arena ---");
+    console_puts("Size: ");
+    console_put_hex(scratch_size);
+    console_puts(" bytes, in use ");
+    console_put_hex(scratch_top);
+    console_puts(", peak ");
+    console_put_hex(scratch_peak);
+    console_puts("\n");
+}
@@ -0,0 +1,17 @@
+#ifndef SCRATCH_H
+#define SCRATCH_H
+
+#include "../include/types.h"
+
+#define SCRATCH_ORDER 5   // 128KB of page frames
+
+// bump-pointer arena for transient buffers; the shell resets it after
+// every command, and nested users can roll back with mark/release
+void scratch_init(void);
+void* scratch_alloc(size_t size);
+size_t scratch_mark(void);
+void scratch_release(size_t mark);
+void scratch_reset(void);
+void scratch_print_info(void);
+
+#endif
@@ -0,0 +1,204 @@
+#include "slab.h"
+#include "page.h"
+#include "../drivers/console.h"
+#include "../include/kernel.h"
+#include "../../lib/string.h"
+
+#define SLAB_HEADER_SIZE ((sizeof(slab_t) + 7) & ~7)
+
+static kmem_cache_t caches[MAX_KMEM_CACHES];
+
+static inline void cache_lock(kmem_cache_t* cache) {
+    while (__sync_lock_test_and_set(&cache->lock, 1)) {
+    }
+}
+
+static inline void cache_unlock(kmem_cache_t* cache) {
+    __sync_lock_release(&cache->lock);
+}
+
+// slabs are single page frames, so an object's slab is its page
+static inline slab_t* slab_of(const void* obj) {
+    return (slab_t*)((uintptr_t)obj & ~(uintptr_t)(SLAB_SIZE - 1));
+}
+
+static inline char* slab_objects(slab_t* slab) {
+    return (char*)slab + SLAB_HEADER_SIZE;
+}
+
+// carve a fresh page into objects and push them onto the cache's free list
+static int cache_grow(kmem_cache_t* cache) {
+    slab_t* slab = (slab_t*)alloc_pages(0);
+    if (!slab) {
+        return -1;
+    }
+    
+    slab->next = cache->slabs;
+    cache->slabs = slab;
+    cache->num_slabs++;
+    memset(slab->free_map, 0, sizeof(slab->free_map));
+    
+    char* obj = slab_objects(slab);
+    for (size_t i = 0; i < cache->objects_per_slab; i++) {
+        if (cache->ctor) {
+            cache->ctor(obj);
+        }
+        *(void**)obj = cache->free_objects;
+        cache->free_objects = obj;
+        slab->free_map[i / 64] |= (uint64_t)1 << (i % 64);
+        obj += cache->object_size;
+    }
+    
+    return 0;
+}
+
+kmem_cache_t* kmem_cache_create(const char* name, size_t size, kmem_ctor_t ctor) {
+    if (size == 0) {
+        return NULL;
+    }
+    
+    // free objects store the free-list link in their first word
+    if (size < sizeof(void*)) {
+        size = sizeof(void*);
+    }
+    size = (size + 7) & ~7;
+    
+    if (size > SLAB_SIZE - SLAB_HEADER_SIZE) {
+        return NULL;
+    }
+    
+    for (int i = 0; i < MAX_KMEM_CACHES; i++) {
+        kmem_cache_t* cache = &caches[i];
+        if (!cache->active) {
+            memset(cache, 0, sizeof(kmem_cache_t));
+            cache->name = name;
+            cache->object_size = size;
+            cache->objects_per_slab = (SLAB_SIZE - SLAB_HEADER_SIZE) / size;
+            cache->ctor = ctor;
+            cache->active = 1;
+            return cache;
+        }
+    }
+    
+    return NULL;
+}
+
+void* kmem_cache_alloc(kmem_cache_t* cache) {
+    if (!cache || !cache->active) {
+        return NULL;
+    }
+    
+    cache_lock(cache);
+    if (!cache->free_objects && cache_grow(cache) != 0) {
+        cache_unlock(cache);
+        return NULL;
+    }
+    
+    void* obj = cache->free_objects;
+    cache->free_objects = *(void**)obj;
+    
+    slab_t* slab = slab_of(obj);
+    size_t index = ((char*)obj - slab_objects(slab)) / cache->object_size;
+    slab->free_map[index / 64] &= ~((uint64_t)1 << (index % 64));
+    
+    cache->objects_in_use++;
+    cache->total_allocs++;
+    cache_unlock(cache);
+    return obj;
+}
+
+// index of obj within a slab of this cache, or -1 if it isn't the start
+// of one of this cache's objects; caller holds the cache lock
+static long cache_object_index(kmem_cache_t* cache, const void* obj) {
+    slab_t* slab = slab_of(obj);
+    slab_t* s = cache->slabs;
+    while (s && s != slab) {
+        s = s->next;
+    }
+    if (!s || (const char*)obj < slab_objects(slab)) {
+        return -1;
+    }
+    
+    size_t offset = (const char*)obj - slab_objects(slab);
+    if (offset % cache->object_size || offset / cache->object_size >= cache->objects_per_slab) {
+        return -1;
+    }
+    return (long)(offset / cache->object_size);
+}
+
+void kmem_cache_free(kmem_cache_t* cache, void* obj) {
+    if (!cache || !obj || !cache->active) {
+        return;
+    }
+    
+    cache_lock(cache);
+    long index = cache_object_index(cache, obj);
+    if (index < 0) {
+        cache_unlock(cache);
+        console_puts("WARNING: Invalid kmem_cache_free() call: ");
+        console_println(cache->name);
+        return;
+    }
+    
+    slab_t* slab = slab_of(obj);
+    uint64_t bit = (uint64_t)1 << (index % 64);
+    if (slab->free_map[index / 64] & bit) {
+        kernel_panic("kmem_cache_free: double free");
+    }
+    slab->free_map[index / 64] |= bit;
+    
+    *(void**)obj = cache->free_objects;
+    cache->free_objects = obj;
+    cache->objects_in_use--;
+    cache_unlock(cache);
+}
+
+void kmem_cache_destroy(kmem_cache_t* cache) {
+    if (!cache || !cache->active) {
+        return;
+    }
+    
+    if (cache->objects_in_use) {
+        console_puts("WARNING: destroying cache with live objects: ");
+        console_println(cache->name);
+    }
+    
+    slab_t* slab = cache->slabs;
+    while (slab) {
+        slab_t* next = slab->next;
+        free_pages(slab, 0);
+        slab = next;
+    }
+    
+    cache->active = 0;
+}
+
+void kmem_cache_print_info(void) {
+    console_println("\n--- Slab Caches ---");
+    
+    int shown = 0;
+    for (int i = 0; i < MAX_KMEM_CACHES; i++) {
+        kmem_cache_t* cache = &caches[i];
+        if (!cache->active) {
+            continue;
+        }
+        
+        console_puts(cache->name);
+        console_puts(": object size ");
+        console_put_hex(cache->object_size);
+        console_puts(", in use ");
+        console_put_hex(cache->objects_in_use);
+        console_puts("/");
+        console_put_hex(cache->num_slabs * cache->objects_per_slab);
+        console_puts(", slabs ");
+        console_put_hex(cache->num_slabs);
+        console_puts(", allocs ");
+        console_put_hex(cache->total_allocs);
+        console_puts("\n");
+        shown++;
+    }
+    
+    if (!shown) {
+        console_println("No slab caches");
+    }
+}
@@ -0,0 +1,43 @@
+#ifndef SLAB_H
+#define SLAB_H
+
+#include "../include/types.h"
+
+#define MAX_KMEM_CACHES 16
+#define SLAB_SIZE 4096   // one page frame
+#define SLAB_MAX_OBJECTS (SLAB_SIZE / 8)
+
+// optional constructor, run once when an object is carved from a new slab;
+// objects go back to kmem_cache_free in their constructed state, except for
+// the first word, which holds the free-list link while the object is free
+typedef void (*kmem_ctor_t)(void* obj);
+
+// slab page header; objects follow it in the same page
+typedef struct slab {
+    struct slab* next;
+    uint64_t free_map[SLAB_MAX_OBJECTS / 64];   // bit set while the object is free
+} slab_t;
+
+// object cache for one fixed object size
+typedef struct {
+    const char* name;
+    size_t object_size;        // rounded up to pointer alignment
+    size_t objects_per_slab;
+    kmem_ctor_t ctor;
+    void* free_objects;        // free objects, linked through their first word
+    slab_t* slabs;
+    size_t num_slabs;
+    size_t objects_in_use;
+    size_t total_allocs;
+    volatile int lock;
+    int active;
+} kmem_cache_t;
+
+// public API
+kmem_cache_t* kmem_cache_create(const char* name, size_t size, kmem_ctor_t ctor);
+void* kmem_cache_alloc(kmem_cache_t* cache);
+void kmem_cache_free(kmem_cache_t* cache, void* obj);
+void kmem_cache_destroy(kmem_cache_t* cache);
+void kmem_cache_print_info(void);
+
+#endif
@@ -1,8 +1,16 @@
 #include "shell.h"
 #include "../drivers/console.h"
 #include "../memory/memory.h"
+#include "../memory/slab.h"
+#include "../memory/page.h"
+#include "../memory/scratch.h"
 #include "../include/kernel.h"
 #include "../../lib/string.h"
+#include "../../lib/ahocorasick.h"
+#include "../../lib/regex.h"
+#include "../../lib/hash.h"
+#include "../../lib/lz4.h"
+#include "../drivers/timer.h"
 #include "../fs/fs.h"   
 #include <stdbool.h>
 #include "../editor/editor.h"
@@ -10,6 +18,9 @@
 #define MAX_COMMAND_LENGTH 256
 #define MAX_ARGS 10
 #define MAX_FILE_SIZE 4096
+#define REGEX_WORK_SIZE (16 * 1024)   // NFA plus DFA cache for grep -E
+#define HASHBENCH_DEFAULT_KB 64
+#define HASHBENCH_MAX_KB 4096
 
 #define HISTORY_SIZE 20
 static char command_history[HISTORY_SIZE][MAX_COMMAND_LENGTH];
@@ -36,14 +47,13 @@ static const char* valid_commands[] = {
     "help", "ls", "cd", "pwd", "mkdir", "rmdir", "rm", "touch", "cat",
     "about", "mem", "calc", "clear", "echo", "colortest", "panic", 
     "edit", "code", "compile", "run", "syntax", "cp", "mv", "find", 
-    "grep", "exit", "quit", NULL
+    "grep", "memprof", "ktrace", "hashbench", "lz4", "exit", "quit", NULL
 };
 
 // declarations for helper functions
 static void display_line_with_highlighting(const char* line, const char* ext);
 static void highlight_word(const char* word, const char* ext);
 static const char* get_file_extension(const char* filename);
-static char* simple_strtok(char* str, const char* delim) __attribute__((unused));
 
 typedef struct {
     const char* name;
@@ -55,6 +65,10 @@ typedef struct {
 static void cmd_help(int argc, char* argv[]);
 static void cmd_about(int argc, char* argv[]);
 static void cmd_mem(int argc, char* argv[]);
+static void cmd_memprof(int argc, char* argv[]);
+static void cmd_ktrace(int argc, char* argv[]);
+static void cmd_hashbench(int argc, char* argv[]);
+static void cmd_lz4(int argc, char* argv[]);
 static void cmd_calc(int argc, char* argv[]);
 static void cmd_clear(int argc, char* argv[]);
 static void cmd_echo(int argc, char* argv[]);
@@ -84,49 +98,15 @@ static int parse_command(char* input, char* args[], int max_args);
 static void execute_command(int argc, char* argv[]);
 static int simple_atoi(const char* str);
 
-static const char* verilog_keywords[] = {
-    "module", "endmodule", "input", "output", "inout", "wire", "reg", "parameter",
-    "always", "initial", "begin", "end", "if", "else", "case", "endcase",
-    "default", "for", "while", "assign", "posedge", "negedge", "or", "and",
-    "not", "nand", "nor", "xor", "xnor", "integer", "real", "time", "genvar",
-    "generate", "endgenerate", "function", "endfunction", "task", "endtask",
-    "logic", "bit", "byte", "shortint", "int", "longint", "typedef", "struct",
-    "union", "enum", "interface", "modport", "clocking", "property", "sequence",
-    "always_ff", "always_comb", "always_latch", "unique", "priority",
-    NULL
-};
-
-static const char* c_keywords[] = {
-    "int", "char", "float", "double", "void", "long", "short", "unsigned",
-    "signed", "const", "static", "volatile", "extern", "auto", "register",
-    "struct", "union", "enum", "typedef", "sizeof", "if", "else", "for",
-    "while", "do", "switch", "case", "default", "break", "continue", "return",
-    "goto", "inline", "restrict", "bool", "_Bool", "true", "false",
-    NULL
-};
-
-static const char* asm_keywords[] = {
-    "add", "sub", "mul", "div", "and", "or", "xor", "sll", "srl", "sra",
-    "beq", "bne", "blt", "bge", "bltu", "bgeu", "jal", "jalr", "lui", "auipc",
-    "lb", "lh", "lw", "lbu", "lhu", "sb", "sh", "sw", "addi", "slti", "sltiu",
-    "xori", "ori", "andi", "slli", "srli", "srai", "fence", "ecall", "ebreak",
-    ".text", ".data", ".bss", ".section", ".global", ".word", ".byte", ".ascii",
-    ".string", ".align", "nop", "mv", "li", "la", "ret", "j", "jr",
-    "x0", "x1", "x2", "x3", "x4", "x5", "x6", "x7", "x8", "x9",
-    "x10", "x11", "x12", "x13", "x14", "x15", "x16", "x17", "x18", "x19",
-    "x20", "x21", "x22", "x23", "x24", "x25", "x26", "x27", "x28", "x29",
-    "x30", "x31", "zero", "ra", "sp", "gp", "tp", "t0", "t1", "t2",
-    "s0", "fp", "s1", "a0", "a1", "a2", "a3", "a4", "a5", "a6", "a7",
-    "s2", "s3", "s4", "s5", "s6", "s7", "s8", "s9", "s10", "s11",
-    "t3", "t4", "t5", "t6",
-    NULL
-};
-
 // command table  
 static command_t commands[] = {
     {"help", "Show available commands", cmd_help},
     {"about", "Show system information", cmd_about},
-    {"mem", "Show memory usage", cmd_mem},
+    {"mem", "Show memory usage (mem -v for heap details)", cmd_mem},
+    {"memprof", "Show top allocation sites (memprof [count])", cmd_memprof},
+    {"ktrace", "Dump or clear the kmalloc trace", cmd_ktrace},
+    {"hashbench", "Measure CRC32C and xxHash64 throughput (hashbench [KB])", cmd_hashbench},
+    {"lz4", "Show how well a file compresses with LZ4", cmd_lz4},
     {"calc", "Simple calculator (calc 2 + 3)", cmd_calc},
     {"clear", "Clear the screen", cmd_clear},
     {"echo", "Echo text back", cmd_echo},
@@ -167,41 +147,6 @@ static bool is_valid_command(const char* cmd) {
     return false;
 }
 
-static char* simple_strtok(char* str, const char* delim) {
-    static char* last_pos = NULL;
-    char* start;
-    
-    if (str != NULL) {
-        last_pos = str;
-    } else if (last_pos == NULL) {
-        return NULL;
-    }
-
-    while (*last_pos && strchr(delim, *last_pos)) {
-        last_pos++;
-    }
-    
-    if (*last_pos == '\0') {
-        last_pos = NULL;
-        return NULL;
-    }
-    
-    start = last_pos;
-
-    while (*last_pos && !strchr(delim, *last_pos)) {
-        last_pos++;
-    }
-    
-    if (*last_pos) {
-        *last_pos = '\0';
-        last_pos++;
-    } else {
-        last_pos = NULL;
-    }
-    
-    return start;
-}
-
 void shell_init(void) {
     console_println("\n=== Welcome to ChipOS Shell ===");
     console_println("Multi-Language Development Environment");
@@ -217,15 +162,7 @@ void shell_run(void) {
     while (1) {
         char current_path[MAX_PATH_LENGTH];
         if (fs_get_current_path(current_path, sizeof(current_path)) == FS_SUCCESS) {
-            char prompt[MAX_PATH_LENGTH + 32]; 
-            char dir_id_hex[16];
-            itoa(fs_get_current_dir_id(), dir_id_hex, 16);
-            strcpy(prompt, "chip:");
-            strcat(prompt, current_path);
-            strcat(prompt, " [0x");
-            strcat(prompt, dir_id_hex);
-            strcat(prompt, "]$ ");
-            console_prompt(prompt);
+            console_printf("chip:%s [0x%x]$ ", current_path, fs_get_current_dir_id());
         } else {
             console_prompt("chip> ");
         }
@@ -245,35 +182,15 @@ void shell_run(void) {
 
 static int parse_command(char* input, char* args[], int max_args) {
     int argc = 0;
-    char* token = input;
-    
-    // simple tokenization by spaces
-    while (*token && argc < max_args) {
-        // skip leading spaces
-        while (*token == ' ' || *token == '\t') {
-            token++;
-        }
-        
-        if (*token == '\0') {
-            break;
-        }
-        
-        // mark start of argument
-        args[argc] = token;
-        argc++;
-        
-        // gind end of argument
-        while (*token && *token != ' ' && *token != '\t') {
-            token++;
-        }
-        
-        // null-terminate if not at end of string
-        if (*token) {
-            *token = '\0';
-            token++;
-        }
+    char* save;
+
+    // arguments are terminated in place, so args point into input
+    char* token = strtok_r(input, " \t", &save);
+    while (token && argc < max_args) {
+        args[argc++] = token;
+        token = strtok_r(NULL, " \t", &save);
     }
-    
+
     return argc;
 }
 
@@ -318,10 +235,11 @@ static void execute_command(int argc, char* argv[]) {
         return;
     }
     
-    // execute the valid command
+    // execute the valid command; its scratch buffers die with it
     for (int i = 0; commands[i].name != NULL; i++) {
         if (strcmp(argv[0], commands[i].name) == 0) {
             commands[i].handler(argc, argv);
+            scratch_reset();
             return;
         }
     }
@@ -350,15 +268,6 @@ static int simple_atoi(const char* str) {
     return result * sign;
 }
 
-static int is_asm_keyword(const char* word) {
-    for (int i = 0; asm_keywords[i] != NULL; i++) {
-        if (strcmp(word, asm_keywords[i]) == 0) {
-            return 1;
-        }
-    }
-    return 0;
-}
-
 static void highlight_word(const char* word, const char* ext) {
     if (ext && (strcmp(ext, ".c") == 0 || strcmp(ext, ".h") == 0)) {
         if (is_c_keyword(word)) {
@@ -562,7 +471,11 @@ static void cmd_help(int argc __attribute__((unused)), char* argv[] __attribute_
     
     console_println("\nSystem Commands:");
     console_println("  about        - Show system information");
-    console_println("  mem          - Show memory usage");
+    console_println("  mem [-v]     - Show memory usage (-v: heap details)");
+    console_println("  memprof [n]  - Top n allocation sites (MEMPROF=1 builds)");
+    console_println("  ktrace [clear] - Dump kmalloc trace (KTRACE=1 builds)");
+    console_println("  hashbench [KB] - CRC32C/xxHash64 throughput");
+    console_println("  lz4 <file>   - LZ4 compressed size of a file");
     console_println("  calc <expr>  - Simple calculator");
     console_println("  clear        - Clear screen");
     console_println("  echo <text>  - Echo text");
@@ -592,8 +505,159 @@ static void cmd_about(int argc __attribute__((unused)), char* argv[] __attribute
     console_println("");
 }
 
-static void cmd_mem(int argc __attribute__((unused)), char* argv[] __attribute__((unused))) {
+static void cmd_mem(int argc, char* argv[]) {
     memory_print_info();
+    if (argc > 1 && strcmp(argv[1], "-v") == 0) {
+        memory_print_details();
+    }
+    page_print_info();
+    kmem_cache_print_info();
+    scratch_print_info();
+}
+
+static void cmd_memprof(int argc, char* argv[]) {
+    int max_sites = 10;
+    if (argc > 1) {
+        max_sites = simple_atoi(argv[1]);
+        if (max_sites <= 0) {
+            console_println("Usage: memprof [count]");
+            return;
+        }
+    }
+    memprof_print(max_sites);
+}
+
+static void cmd_ktrace(int argc, char* argv[]) {
+    if (argc > 1 && strcmp(argv[1], "clear") == 0) {
+        ktrace_clear();
+        return;
+    }
+    if (argc > 1) {
+        console_println("Usage: ktrace [clear]");
+        return;
+    }
+    ktrace_dump();
+}
+
+static uint64_t bench_crc32c(const void* data, size_t length) {
+    return crc32c(data, length);
+}
+
+static uint64_t bench_crc32c_table(const void* data, size_t length) {
+    return crc32c_update_table(0, data, length);
+}
+
+static uint64_t bench_xxh64(const void* data, size_t length) {
+    return xxh64(data, length, 0);
+}
+
+// hashes the same buffer over and over for about a quarter of a second
+// per function; the buffer stays cache-hot, so this is the compute bound
+static void cmd_hashbench(int argc, char* argv[]) {
+    int kb = HASHBENCH_DEFAULT_KB;
+    if (argc > 1) {
+        kb = simple_atoi(argv[1]);
+        if (kb <= 0 || kb > HASHBENCH_MAX_KB) {
+            console_printf("Usage: hashbench [KB] (1-%d)\n", HASHBENCH_MAX_KB);
+            return;
+        }
+    }
+
+    size_t size = (size_t)kb * 1024;
+    unsigned int order = page_order_for_size(size);
+    uint8_t* buffer = alloc_pages(order);
+    if (!buffer) {
+        console_println("hashbench: out of memory");
+        return;
+    }
+
+    uint64_t x = 0x9E3779B97F4A7C15UL;
+    for (size_t i = 0; i < size; i++) {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        buffer[i] = (uint8_t)x;
+    }
+
+    struct {
+        const char* name;
+        uint64_t (*run)(const void* data, size_t length);
+    } benches[] = {
+        { "crc32c", bench_crc32c },
+        { "crc32c-table", bench_crc32c_table },
+        { "xxh64", bench_xxh64 },
+    };
+
+    uint64_t frequency = timer_frequency();
+    console_printf("%d KB buffer, CRC32C using %s, timer %lu Hz\n",
+                   kb, hash_crc32c_impl_name(), (unsigned long)frequency);
+
+    for (size_t b = 0; b < sizeof(benches) / sizeof(benches[0]); b++) {
+        uint64_t result = 0;
+        uint64_t bytes = 0;
+        uint64_t start = timer_ticks();
+        uint64_t elapsed;
+        do {
+            result ^= benches[b].run(buffer, size);
+            bytes += size;
+            elapsed = timer_ticks() - start;
+        } while (elapsed < frequency / 4);
+
+        // hundredths of a GB/s
+        uint64_t centi = bytes * frequency / (elapsed * 10000000UL);
+        console_printf("  %-13s %3lu.%02lu GB/s  %lu MB in %lu us  (%016lx)\n",
+                       benches[b].name, (unsigned long)(centi / 100), (unsigned long)(centi % 100),
+                       (unsigned long)(bytes >> 20), (unsigned long)timer_ticks_to_us(elapsed),
+                       (unsigned long)result);
+    }
+
+    free_pages(buffer, order);
+}
+
+// compresses and decompresses a file without changing it, and checks the
+// round trip
+static void cmd_lz4(int argc, char* argv[]) {
+    if (argc < 2) {
+        console_println("Usage: lz4 <file>");
+        return;
+    }
+
+    size_t bound = LZ4_COMPRESS_BOUND(MAX_FILE_SIZE);
+    char* data = scratch_alloc(MAX_FILE_SIZE);
+    char* compressed = scratch_alloc(bound);
+    char* restored = scratch_alloc(MAX_FILE_SIZE);
+    lz4_table_t* table = scratch_alloc(sizeof(lz4_table_t));
+    if (!data || !compressed || !restored || !table) {
+        console_println("lz4: out of scratch memory");
+        return;
+    }
+
+    int size = fs_read_file(argv[1], data, MAX_FILE_SIZE);
+    if (size < 0) {
+        console_printf("lz4: cannot read '%s'\n", argv[1]);
+        return;
+    }
+
+    uint64_t start = timer_ticks();
+    int packed = lz4_compress(data, size, compressed, bound, table);
+    uint64_t middle = timer_ticks();
+    if (packed < 0) {
+        console_printf("lz4: %s\n", lz4_error_string(packed));
+        return;
+    }
+    int unpacked = lz4_decompress(compressed, packed, restored, MAX_FILE_SIZE);
+    uint64_t end = timer_ticks();
+
+    if (unpacked != size || memcmp(data, restored, size) != 0) {
+        console_println("lz4: round trip mismatch");
+        return;
+    }
+
+    int permille = size ? (int)((uint64_t)packed * 1000 / size) : 0;
+    console_printf("%s: %d -> %d bytes (%d.%d%%), compress %lu us, decompress %lu us\n",
+                   argv[1], size, packed, permille / 10, permille % 10,
+                   (unsigned long)timer_ticks_to_us(middle - start),
+                   (unsigned long)timer_ticks_to_us(end - middle));
 }
 
 static void cmd_calc(int argc, char* argv[]) {
@@ -629,7 +693,7 @@ static void cmd_calc(int argc, char* argv[]) {
     
     if (valid) {
         console_puts("Result: ");
-        console_put_hex(result);
+        console_put_hex((unsigned int)result);
         console_println("");
     }
 }
@@ -730,13 +794,7 @@ static void cmd_cd(int argc, char* argv[]) {
         return;
     }
     
-    console_puts("DEBUG: Raw argument received: '");
-    console_puts(argv[1]);
-    console_puts("' (length: ");
-    char len_buf[16];
-    itoa(strlen(argv[1]), len_buf, 10);
-    console_puts(len_buf);
-    console_puts(")\n");
+    console_printf("DEBUG: Raw argument received: '%s' (length: %zu)\n", argv[1], strlen(argv[1]));
     
     console_puts("DEBUG: Changing to directory: ");
     console_println(argv[1]);
@@ -803,7 +861,12 @@ static void cmd_cat(int argc, char* argv[]) {
         return;
     }
     
-    char buffer[MAX_FILE_SIZE];
+    char* buffer = scratch_alloc(MAX_FILE_SIZE);
+    if (!buffer) {
+        console_println("cat: out of scratch memory");
+        return;
+    }
+    
     int bytes_read = fs_read_file(argv[1], buffer, MAX_FILE_SIZE - 1);
     
     if (bytes_read < 0) {
@@ -852,7 +915,12 @@ static void cmd_cp(int argc, char* argv[]) {
         return;
     }
     
-    char buffer[MAX_FILE_SIZE];
+    char* buffer = scratch_alloc(MAX_FILE_SIZE);
+    if (!buffer) {
+        console_println("cp: out of scratch memory");
+        return;
+    }
+    
     int bytes_read = fs_read_file(argv[1], buffer, MAX_FILE_SIZE);
     
     if (bytes_read < 0) {
@@ -883,7 +951,12 @@ static void cmd_mv(int argc, char* argv[]) {
     }
     
     // First copy the file
-    char buffer[MAX_FILE_SIZE];
+    char* buffer = scratch_alloc(MAX_FILE_SIZE);
+    if (!buffer) {
+        console_println("mv: out of scratch memory");
+        return;
+    }
+    
     int bytes_read = fs_read_file(argv[1], buffer, MAX_FILE_SIZE);
     
     if (bytes_read < 0) {
@@ -937,17 +1010,208 @@ static void cmd_find(int argc, char* argv[]) {
     }
 }
 
+static void grep_print_line(int line_number, const char* start, const char* end) {
+    char line[256];
+    size_t len = end - start;
+    if (len > sizeof(line) - 1) {
+        len = sizeof(line) - 1;
+    }
+    memcpy(line, start, len);
+    line[len] = '\0';
+
+    console_put_hex((unsigned int)line_number);
+    console_puts(": ");
+    console_println(line);
+}
+
+// one pattern: search the whole buffer with it precompiled and only work
+// out line boundaries around the hits, instead of rescanning line by line
+static int grep_single(const char* pattern, const char* buffer, const char* end) {
+    str_search_t search;
+    str_search_init(&search, pattern, strlen(pattern));
+
+    const char* pos = buffer;
+    const char* counted = buffer;
+    int line_number = 1;
+    int matches_found = 0;
+
+    while (pos <= end) {
+        const char* hit = str_search_find(&search, pos, end - pos);
+        if (!hit) {
+            break;
+        }
+
+        const char* line_start = hit;
+        while (line_start > pos && line_start[-1] != '\n') {
+            line_start--;
+        }
+        const char* line_end = memchr(hit, '\n', end - hit);
+        if (!line_end) {
+            line_end = end;
+        }
+
+        // a hit spanning a newline is not a match on any single line
+        if (hit + search.length <= line_end) {
+            while ((counted = memchr(counted, '\n', line_start - counted)) != NULL) {
+                counted++;
+                line_number++;
+            }
+            counted = line_start;
+
+            grep_print_line(line_number, line_start, line_end);
+            matches_found++;
+        }
+
+        pos = line_end + 1;
+    }
+
+    return matches_found;
+}
+
+// several patterns (-e): one Aho-Corasick pass over the buffer, restarting
+// at every newline so matches stay within a line; -1 if out of memory
+static int grep_multi(char* patterns[], int count, const char* buffer, const char* end) {
+    size_t total = 1;
+    bool match_all = false;
+    for (int i = 0; i < count; i++) {
+        total += strlen(patterns[i]);
+        if (patterns[i][0] == '\0') {
+            match_all = true;
+        }
+    }
+
+    ac_node_t* nodes = scratch_alloc(total * sizeof(ac_node_t));
+    if (!nodes) {
+        return -1;
+    }
+
+    ac_automaton_t ac;
+    ac_init(&ac, nodes, (uint16_t)total);
+    for (int i = 0; i < count; i++) {
+        ac_add(&ac, patterns[i], strlen(patterns[i]), i);
+    }
+    ac_build(&ac);
+
+    uint16_t state = AC_ROOT;
+    const char* line_start = buffer;
+    bool matched = match_all;
+    int line_number = 1;
+    int matches_found = 0;
+
+    for (const char* p = buffer; p <= end; p++) {
+        if (p == end || *p == '\n') {
+            if (matched) {
+                grep_print_line(line_number, line_start, p);
+                matches_found++;
+            }
+            line_number++;
+            line_start = p + 1;
+            state = AC_ROOT;
+            matched = match_all;
+        } else if (!matched) {
+            state = ac_step(&ac, state, (unsigned char)*p);
+            matched = ac_match(&ac, state) != AC_ROOT;
+        }
+    }
+
+    return matches_found;
+}
+
+// -E: one regex (several -e patterns are joined with |), run line by line
+// through the lazily built DFA; -1 if out of memory, -2 on a bad pattern
+static int grep_regex(char* patterns[], int count, const char* buffer, const char* end) {
+    char* pattern = patterns[0];
+    if (count > 1) {
+        pattern = scratch_alloc(REGEX_MAX_PATTERN + 1);
+        if (!pattern) {
+            return -1;
+        }
+        pattern[0] = '\0';
+        size_t length = 0;
+        for (int i = 0; i < count; i++) {
+            length += strlen(patterns[i]) + 3;
+            if (length > REGEX_MAX_PATTERN) {
+                console_puts("grep: ");
+                console_println(regex_error_string(REGEX_ERROR_TOO_LONG));
+                return -2;
+            }
+            strcat(pattern, i ? "|(" : "(");
+            strcat(pattern, patterns[i]);
+            strcat(pattern, ")");
+        }
+    }
+
+    void* work = scratch_alloc(REGEX_WORK_SIZE);
+    if (!work) {
+        return -1;
+    }
+
+    regex_t re;
+    int error = regex_compile(&re, pattern, work, REGEX_WORK_SIZE);
+    if (error != REGEX_OK) {
+        console_puts("grep: ");
+        console_puts(regex_error_string(error));
+        console_puts(" in '");
+        console_puts(pattern);
+        console_println("'");
+        return -2;
+    }
+
+    const char* line_start = buffer;
+    int line_number = 1;
+    int matches_found = 0;
+
+    while (line_start <= end) {
+        const char* line_end = memchr(line_start, '\n', end - line_start);
+        if (!line_end) {
+            line_end = end;
+        }
+        if (regex_search(&re, line_start, line_end - line_start)) {
+            grep_print_line(line_number, line_start, line_end);
+            matches_found++;
+        }
+        line_number++;
+        line_start = line_end + 1;
+    }
+
+    return matches_found;
+}
+
 static void cmd_grep(int argc, char* argv[]) {
-    if (argc < 3) {
+    char* patterns[MAX_ARGS];
+    int count = 0;
+    int arg = 1;
+    bool extended = false;
+
+    if (arg < argc && strcmp(argv[arg], "-E") == 0) {
+        extended = true;
+        arg++;
+    }
+
+    while (arg + 1 < argc && strcmp(argv[arg], "-e") == 0) {
+        patterns[count++] = argv[arg + 1];
+        arg += 2;
+    }
+    if (count == 0 && arg < argc) {
+        patterns[count++] = argv[arg++];
+    }
+
+    if (count == 0 || arg != argc - 1) {
         console_println("Usage: grep <pattern> <file>");
-        console_println("Simple grep - searches for pattern in file");
+        console_println("       grep -e <pattern> [-e <pattern>]... <file>");
+        console_println("       grep -E <regex> <file>   (also with -e)");
+        console_println("Simple grep - prints lines containing any of the patterns");
         return;
     }
     
-    char* pattern = argv[1];
-    char* filename = argv[2];
+    char* filename = argv[arg];
+    
+    char* buffer = scratch_alloc(MAX_FILE_SIZE);
+    if (!buffer) {
+        console_println("grep: out of scratch memory");
+        return;
+    }
     
-    char buffer[MAX_FILE_SIZE];
     int bytes_read = fs_read_file(filename, buffer, MAX_FILE_SIZE - 1);
     
     if (bytes_read < 0) {
@@ -957,38 +1221,32 @@ static void cmd_grep(int argc, char* argv[]) {
         return;
     }
     
-    buffer[bytes_read] = '\0';
-    
-    // simple line-based search
-    char line[256];
-    int line_pos = 0;
-    int buffer_pos = 0;
-    int line_number = 1;
-    int matches_found = 0;
-    
-    while (buffer_pos <= bytes_read) {
-        if (buffer[buffer_pos] == '\n' || buffer[buffer_pos] == '\0') {
-            line[line_pos] = '\0';
-            
-            if (strstr(line, pattern) != NULL) {
-                console_put_hex(line_number);
-                console_puts(": ");
-                console_println(line);
-                matches_found++;
-            }
-            
-            line_pos = 0;
-            line_number++;
-        } else if (line_pos < 255) {
-            line[line_pos++] = buffer[buffer_pos];
-        }
-        buffer_pos++;
+    const char* end = buffer + bytes_read;
+    int matches_found;
+    if (extended) {
+        matches_found = grep_regex(patterns, count, buffer, end);
+    } else if (count == 1) {
+        matches_found = grep_single(patterns[0], buffer, end);
+    } else {
+        matches_found = grep_multi(patterns, count, buffer, end);
+    }
+    if (matches_found == -1) {
+        console_println("grep: out of scratch memory");
+        return;
+    }
+    if (matches_found < 0) {
+        return;
     }
     
     if (matches_found == 0) {
         console_puts("grep: no matches found for '");
-        console_puts(pattern);
-        console_puts("' in '");
+        console_puts(patterns[0]);
+        if (count > 1) {
+            console_puts("' or the other patterns");
+        } else {
+            console_puts("'");
+        }
+        console_puts(" in '");
         console_puts(filename);
         console_println("'");
     }
@@ -1014,7 +1272,12 @@ static void cmd_edit(int argc, char* argv[]) {
     console_println("----------------------------------------");
     
     // read existing content if file exists
-    char file_buffer[MAX_FILE_SIZE];
+    char* file_buffer = scratch_alloc(MAX_FILE_SIZE);
+    if (!file_buffer) {
+        console_println("edit: out of scratch memory");
+        return;
+    }
+    
     int existing_size = fs_read_file(filename, file_buffer, MAX_FILE_SIZE - 1);
     int total_size = 0;
     
@@ -1237,7 +1500,12 @@ static void cmd_syntax(int argc, char* argv[]) {
     console_puts(filename);
     console_println("");
     
-    char buffer[MAX_FILE_SIZE];
+    char* buffer = scratch_alloc(MAX_FILE_SIZE);
+    if (!buffer) {
+        console_println("syntax: out of scratch memory");
+        return;
+    }
+    
     int bytes_read = fs_read_file(filename, buffer, MAX_FILE_SIZE - 1);
     
     if (bytes_read < 0) {
@@ -1271,7 +1539,7 @@ static void cmd_syntax(int argc, char* argv[]) {
             console_println("✓ Braces balanced");
         } else {
             console_puts("✗ Unbalanced braces: ");
-            console_put_hex(brace_count);
+            console_put_hex((unsigned int)brace_count);
             console_println("");
         }
         
@@ -1279,12 +1547,12 @@ static void cmd_syntax(int argc, char* argv[]) {
             console_println("✓ Parentheses balanced");
         } else {
             console_puts("✗ Unbalanced parentheses: ");
-            console_put_hex(paren_count);
+            console_put_hex((unsigned int)paren_count);
             console_println("");
         }
         
         console_puts("Lines: ");
-        console_put_hex(line_num);
+        console_put_hex((unsigned int)line_num);
         console_println("");
         
     } else if (ext && (strcmp(ext, ".v") == 0 || strcmp(ext, ".sv") == 0)) {
@@ -1352,16 +1620,16 @@ static void cmd_syntax(int argc, char* argv[]) {
         }
         
         console_puts("Instructions: ");
-        console_put_hex(instruction_count);
+        console_put_hex((unsigned int)instruction_count);
         console_println("");
         console_puts("Directives: ");
-        console_put_hex(directive_count);
+        console_put_hex((unsigned int)directive_count);
         console_println("");
         
     } else {
         console_println("Unknown file type - basic text analysis:");
         console_puts("File size: ");
-        console_put_hex(bytes_read);
+        console_put_hex((unsigned int)bytes_read);
         console_println(" bytes");
     }
     
@@ -0,0 +1,107 @@
+#include "ahocorasick.h"
+#include "string.h"
+
+void ac_init(ac_automaton_t* ac, ac_node_t* nodes, uint16_t capacity) {
+    ac->nodes = nodes;
+    ac->capacity = capacity;
+    ac->count = 1;
+    memset(&nodes[AC_ROOT], 0, sizeof(ac_node_t));
+    nodes[AC_ROOT].pattern = -1;
+}
+
+static uint16_t ac_child(const ac_automaton_t* ac, uint16_t node, unsigned char byte) {
+    for (uint16_t c = ac->nodes[node].child; c != AC_ROOT; c = ac->nodes[c].sibling) {
+        if (ac->nodes[c].byte == byte) {
+            return c;
+        }
+    }
+    return AC_ROOT;
+}
+
+int ac_add(ac_automaton_t* ac, const char* pattern, size_t length, int id) {
+    uint16_t node = AC_ROOT;
+
+    for (size_t i = 0; i < length; i++) {
+        unsigned char byte = (unsigned char)pattern[i];
+        uint16_t next = ac_child(ac, node, byte);
+        if (next == AC_ROOT) {
+            if (ac->count >= ac->capacity) {
+                return -1;
+            }
+            next = ac->count++;
+            ac_node_t* n = &ac->nodes[next];
+            memset(n, 0, sizeof(ac_node_t));
+            n->byte = byte;
+            n->depth = ac->nodes[node].depth + 1;
+            n->pattern = -1;
+            n->sibling = ac->nodes[node].child;
+            ac->nodes[node].child = next;
+        }
+        node = next;
+    }
+
+    // the empty pattern would match everywhere; ignore it
+    if (node != AC_ROOT && ac->nodes[node].pattern < 0) {
+        ac->nodes[node].pattern = (int16_t)id;
+    }
+    return 0;
+}
+
+uint16_t ac_step(const ac_automaton_t* ac, uint16_t state, unsigned char byte) {
+    for (;;) {
+        uint16_t next = ac_child(ac, state, byte);
+        if (next != AC_ROOT || state == AC_ROOT) {
+            return next;
+        }
+        state = ac->nodes[state].fail;
+    }
+}
+
+// fail links breadth first, so every shallower node is finished before a
+// deeper one looks through it
+void ac_build(ac_automaton_t* ac) {
+    ac_node_t* nodes = ac->nodes;
+    uint16_t tail = AC_ROOT;
+
+    nodes[AC_ROOT].queue = AC_ROOT;
+    for (uint16_t c = nodes[AC_ROOT].child; c != AC_ROOT; c = nodes[c].sibling) {
+        nodes[c].fail = AC_ROOT;
+        nodes[c].output = AC_ROOT;
+        nodes[tail].queue = c;
+        nodes[c].queue = AC_ROOT;
+        tail = c;
+    }
+
+    uint16_t head = nodes[AC_ROOT].queue;
+    while (head != AC_ROOT) {
+        for (uint16_t c = nodes[head].child; c != AC_ROOT; c = nodes[c].sibling) {
+            uint16_t fail = ac_step(ac, nodes[head].fail, nodes[c].byte);
+            nodes[c].fail = fail;
+            nodes[c].output = nodes[fail].pattern >= 0 ? fail : nodes[fail].output;
+            nodes[tail].queue = c;
+            nodes[c].queue = AC_ROOT;
+            tail = c;
+        }
+        head = nodes[head].queue;
+    }
+}
+
+uint16_t ac_match(const ac_automaton_t* ac, uint16_t state) {
+    return ac->nodes[state].pattern >= 0 ? state : ac->nodes[state].output;
+}
+
+int ac_search(const ac_automaton_t* ac, const char* text, size_t length,
+              ac_found_t found, void* ctx) {
+    uint16_t state = AC_ROOT;
+
+    for (size_t i = 0; i < length; i++) {
+        state = ac_step(ac, state, (unsigned char)text[i]);
+        for (uint16_t m = ac_match(ac, state); m != AC_ROOT; m = ac->nodes[m].output) {
+            int stop = found(ac->nodes[m].pattern, i + 1, ctx);
+            if (stop) {
+                return stop;
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,50 @@
+#ifndef AHOCORASICK_H
+#define AHOCORASICK_H
+
+#include "../kernel/include/types.h"
+
+// Aho-Corasick automaton: any number of patterns matched in one pass over
+// the text. Nodes come from caller-supplied storage; a trie over patterns
+// of total length n needs at most n + 1 of them. Add every pattern, call
+// ac_build() once, then step or search.
+
+#define AC_ROOT 0
+
+typedef struct {
+    uint16_t child;     // first child, AC_ROOT if none
+    uint16_t sibling;   // next child of the same parent
+    uint16_t fail;      // longest proper suffix that is also in the trie
+    uint16_t output;    // nearest node on the fail chain ending a pattern
+    uint16_t depth;     // length of the string spelled by this node
+    uint16_t queue;     // breadth-first order, only used by ac_build()
+    int16_t pattern;    // id of the pattern ending here, -1 if none
+    uint8_t byte;
+} ac_node_t;
+
+typedef struct {
+    ac_node_t* nodes;
+    uint16_t capacity;
+    uint16_t count;
+} ac_automaton_t;
+
+void ac_init(ac_automaton_t* ac, ac_node_t* nodes, uint16_t capacity);
+
+// returns 0, or -1 if the node storage is full
+int ac_add(ac_automaton_t* ac, const char* pattern, size_t length, int id);
+
+void ac_build(ac_automaton_t* ac);
+
+// streaming interface: feed one byte, starting from AC_ROOT
+uint16_t ac_step(const ac_automaton_t* ac, uint16_t state, unsigned char byte);
+
+// node of the longest pattern ending at state, AC_ROOT if none; follow
+// nodes[n].output for the shorter ones
+uint16_t ac_match(const ac_automaton_t* ac, uint16_t state);
+
+// calls found(id, end, ctx) for every match, end being one past its last
+// byte; a nonzero return stops the scan and is passed back
+typedef int (*ac_found_t)(int id, size_t end, void* ctx);
+int ac_search(const ac_automaton_t* ac, const char* text, size_t length,
+              ac_found_t found, void* ctx);
+
+#endif
@@ -0,0 +1,316 @@
+#include "hash.h"
+
+typedef uint64_t __attribute__((may_alias)) hash_word_t;
+typedef uint32_t __attribute__((may_alias)) hash_half_t;
+
+// reflected Castagnoli polynomial
+#define CRC32C_POLY 0x82F63B78U
+
+// crc_table[0] is the classic byte table; crc_table[k] advances a byte
+// through k more zero bytes, so eight lookups consume a whole word
+static uint32_t crc_table[8][256];
+
+#ifdef __riscv
+static uint32_t crc32c_update_clmul(uint32_t crc, const void* data, size_t length);
+#endif
+
+static struct {
+    const char* name;
+    uint32_t (*crc32c_update)(uint32_t crc, const void* data, size_t length);
+} hash_ops = { "table", crc32c_update_table };
+
+static void crc_build_tables(void) {
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t crc = i;
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ ((crc & 1) ? CRC32C_POLY : 0);
+        }
+        crc_table[0][i] = crc;
+    }
+    for (uint32_t i = 0; i < 256; i++) {
+        for (int k = 1; k < 8; k++) {
+            uint32_t prev = crc_table[k - 1][i];
+            crc_table[k][i] = (prev >> 8) ^ crc_table[0][prev & 0xff];
+        }
+    }
+}
+
+void hash_init(unsigned int features) {
+    crc_build_tables();
+#ifdef __riscv
+    if (features & HASH_FEATURE_ZBC) {
+        hash_ops.name = "Zbc";
+        hash_ops.crc32c_update = crc32c_update_clmul;
+    }
+#else
+    (void)features;   // host builds (tools/) only have the table
+#endif
+}
+
+const char* hash_crc32c_impl_name(void) {
+    return hash_ops.name;
+}
+
+uint32_t crc32c_update(uint32_t crc, const void* data, size_t length) {
+    return hash_ops.crc32c_update(crc, data, length);
+}
+
+uint32_t crc32c(const void* data, size_t length) {
+    return hash_ops.crc32c_update(0, data, length);
+}
+
+static inline uint32_t crc_byte(uint32_t crc, uint8_t byte) {
+    return crc_table[0][(crc ^ byte) & 0xff] ^ (crc >> 8);
+}
+
+uint32_t crc32c_update_table(uint32_t crc, const void* data, size_t length) {
+    const uint8_t* p = data;
+
+    // host tools never call hash_init()
+    if (!crc_table[0][1]) {
+        crc_build_tables();
+    }
+
+    crc = ~crc;
+    while (length && ((uintptr_t)p & 7)) {
+        crc = crc_byte(crc, *p++);
+        length--;
+    }
+
+    while (length >= 8) {
+        uint64_t w = *(const hash_word_t*)p ^ crc;
+        crc = crc_table[7][w & 0xff] ^
+              crc_table[6][(w >> 8) & 0xff] ^
+              crc_table[5][(w >> 16) & 0xff] ^
+              crc_table[4][(w >> 24) & 0xff] ^
+              crc_table[3][(w >> 32) & 0xff] ^
+              crc_table[2][(w >> 40) & 0xff] ^
+              crc_table[1][(w >> 48) & 0xff] ^
+              crc_table[0][w >> 56];
+        p += 8;
+        length -= 8;
+    }
+
+    while (length--) {
+        crc = crc_byte(crc, *p++);
+    }
+    return ~crc;
+}
+
+#ifdef __riscv
+// Zbc through .insn like the Zbb string routines. A word folds into the
+// CRC with one Barrett reduction: QT is x^96 / P (bit-reflected, with the
+// x^64 term implicit), so clmul by QT estimates the quotient and clmulr by
+// P takes the remainder.
+#define CRC32C_BARRETT_QT 0xa434f61c6f5389f8UL
+
+static inline uint64_t clmul(uint64_t a, uint64_t b) {
+    uint64_t result;
+    asm (".insn r 0x33, 0x1, 0x5, %0, %1, %2" : "=r" (result) : "r" (a), "r" (b));
+    return result;
+}
+
+static inline uint64_t clmulr(uint64_t a, uint64_t b) {
+    uint64_t result;
+    asm (".insn r 0x33, 0x2, 0x5, %0, %1, %2" : "=r" (result) : "r" (a), "r" (b));
+    return result;
+}
+
+static uint32_t crc32c_update_clmul(uint32_t crc, const void* data, size_t length) {
+    const uint8_t* p = data;
+
+    crc = ~crc;
+    while (length && ((uintptr_t)p & 7)) {
+        crc = crc_byte(crc, *p++);
+        length--;
+    }
+
+    while (length >= 8) {
+        uint64_t s = *(const hash_word_t*)p ^ crc;
+        uint64_t t = (clmul(s, CRC32C_BARRETT_QT) << 1) ^ s;
+        crc = clmulr(t, (uint64_t)CRC32C_POLY << 32) >> 32;
+        p += 8;
+        length -= 8;
+    }
+
+    while (length--) {
+        crc = crc_byte(crc, *p++);
+    }
+    return ~crc;
+}
+#endif
+
+// xxHash64, as in the reference implementation
+#define XXH_PRIME1 0x9E3779B185EBCA87UL
+#define XXH_PRIME2 0xC2B2AE3D27D4EB4FUL
+#define XXH_PRIME3 0x165667B19E3779F9UL
+#define XXH_PRIME4 0x85EBCA77C2B2AE63UL
+#define XXH_PRIME5 0x27D4EB2F165667C5UL
+
+static inline uint64_t rotl64(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+// little-endian loads that don't rely on misaligned access support
+static inline uint64_t read64(const uint8_t* p) {
+    if (!((uintptr_t)p & 7)) {
+        return *(const hash_word_t*)p;
+    }
+    uint64_t value = 0;
+    for (int i = 7; i >= 0; i--) {
+        value = (value << 8) | p[i];
+    }
+    return value;
+}
+
+static inline uint32_t read32(const uint8_t* p) {
+    if (!((uintptr_t)p & 3)) {
+        return *(const hash_half_t*)p;
+    }
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline uint64_t xxh64_round(uint64_t acc, uint64_t input) {
+    acc += input * XXH_PRIME2;
+    acc = rotl64(acc, 31);
+    return acc * XXH_PRIME1;
+}
+
+static inline uint64_t xxh64_merge(uint64_t hash, uint64_t acc) {
+    hash ^= xxh64_round(0, acc);
+    return hash * XXH_PRIME1 + XXH_PRIME4;
+}
+
+// consumes whole 32-byte stripes and returns how many bytes that was
+static size_t xxh64_stripes(uint64_t acc[4], const uint8_t* p, size_t length) {
+    const uint8_t* start = p;
+    uint64_t a0 = acc[0], a1 = acc[1], a2 = acc[2], a3 = acc[3];
+
+    while (length >= 32) {
+        a0 = xxh64_round(a0, read64(p));
+        a1 = xxh64_round(a1, read64(p + 8));
+        a2 = xxh64_round(a2, read64(p + 16));
+        a3 = xxh64_round(a3, read64(p + 24));
+        p += 32;
+        length -= 32;
+    }
+
+    acc[0] = a0;
+    acc[1] = a1;
+    acc[2] = a2;
+    acc[3] = a3;
+    return p - start;
+}
+
+static uint64_t xxh64_converge(const uint64_t acc[4]) {
+    uint64_t hash = rotl64(acc[0], 1) + rotl64(acc[1], 7) +
+                    rotl64(acc[2], 12) + rotl64(acc[3], 18);
+    for (int i = 0; i < 4; i++) {
+        hash = xxh64_merge(hash, acc[i]);
+    }
+    return hash;
+}
+
+// mixes in the last (< 32) bytes and avalanches
+static uint64_t xxh64_finish(uint64_t hash, const uint8_t* p, size_t length) {
+    while (length >= 8) {
+        hash ^= xxh64_round(0, read64(p));
+        hash = rotl64(hash, 27) * XXH_PRIME1 + XXH_PRIME4;
+        p += 8;
+        length -= 8;
+    }
+    if (length >= 4) {
+        hash ^= (uint64_t)read32(p) * XXH_PRIME1;
+        hash = rotl64(hash, 23) * XXH_PRIME2 + XXH_PRIME3;
+        p += 4;
+        length -= 4;
+    }
+    while (length--) {
+        hash ^= *p++ * XXH_PRIME5;
+        hash = rotl64(hash, 11) * XXH_PRIME1;
+    }
+
+    hash ^= hash >> 33;
+    hash *= XXH_PRIME2;
+    hash ^= hash >> 29;
+    hash *= XXH_PRIME3;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+static void xxh64_seed_acc(uint64_t acc[4], uint64_t seed) {
+    acc[0] = seed + XXH_PRIME1 + XXH_PRIME2;
+    acc[1] = seed + XXH_PRIME2;
+    acc[2] = seed;
+    acc[3] = seed - XXH_PRIME1;
+}
+
+uint64_t xxh64(const void* data, size_t length, uint64_t seed) {
+    const uint8_t* p = data;
+    uint64_t hash;
+
+    if (length >= 32) {
+        uint64_t acc[4];
+        xxh64_seed_acc(acc, seed);
+        size_t done = xxh64_stripes(acc, p, length);
+        hash = xxh64_converge(acc);
+        p += done;
+    } else {
+        hash = seed + XXH_PRIME5;
+    }
+
+    hash += length;
+    return xxh64_finish(hash, p, length & 31);
+}
+
+void xxh64_reset(xxh64_state_t* state, uint64_t seed) {
+    state->total = 0;
+    state->buffered = 0;
+    state->seed = seed;
+    xxh64_seed_acc(state->acc, seed);
+}
+
+void xxh64_update(xxh64_state_t* state, const void* data, size_t length) {
+    const uint8_t* p = data;
+    state->total += length;
+
+    // top up a partial stripe first
+    if (state->buffered) {
+        size_t take = 32 - state->buffered;
+        if (take > length) {
+            take = length;
+        }
+        for (size_t i = 0; i < take; i++) {
+            state->buffer[state->buffered + i] = p[i];
+        }
+        state->buffered += take;
+        p += take;
+        length -= take;
+        if (state->buffered < 32) {
+            return;
+        }
+        xxh64_stripes(state->acc, state->buffer, 32);
+        state->buffered = 0;
+    }
+
+    size_t done = xxh64_stripes(state->acc, p, length);
+    p += done;
+    length -= done;
+
+    for (size_t i = 0; i < length; i++) {
+        state->buffer[i] = p[i];
+    }
+    state->buffered = length;
+}
+
+uint64_t xxh64_digest(const xxh64_state_t* state) {
+    uint64_t hash;
+    if (state->total >= 32) {
+        hash = xxh64_converge(state->acc);
+    } else {
+        hash = state->seed + XXH_PRIME5;
+    }
+
+    hash += state->total;
+    return xxh64_finish(hash, state->buffer, state->buffered);
+}
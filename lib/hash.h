@@ -0,0 +1,37 @@
+#ifndef HASH_H
+#define HASH_H
+
+#include "../kernel/include/types.h"
+
+// checksums and hashes over byte buffers: CRC32C (Castagnoli) for
+// integrity checks, xxHash64 for hash tables and content keys. Both have a
+// one-shot and a streaming form that give the same result.
+
+// CPU features hash_init() can use; call it once at boot, before the
+// first CRC (it also builds the lookup tables)
+#define HASH_FEATURE_ZBC 0x1        // carry-less multiply
+void hash_init(unsigned int features);
+const char* hash_crc32c_impl_name(void);
+
+// streaming: start from 0 and pass the previous result back in, so
+// crc32c_update(crc32c_update(0, a), b) == crc32c(a followed by b)
+uint32_t crc32c_update(uint32_t crc, const void* data, size_t length);
+uint32_t crc32c(const void* data, size_t length);
+
+// the portable slicing-by-8 version, whatever hash_init() picked
+uint32_t crc32c_update_table(uint32_t crc, const void* data, size_t length);
+
+typedef struct {
+    uint64_t total;
+    uint64_t acc[4];
+    uint8_t buffer[32];         // tail of the input not yet consumed
+    uint32_t buffered;
+    uint64_t seed;
+} xxh64_state_t;
+
+void xxh64_reset(xxh64_state_t* state, uint64_t seed);
+void xxh64_update(xxh64_state_t* state, const void* data, size_t length);
+uint64_t xxh64_digest(const xxh64_state_t* state);
+uint64_t xxh64(const void* data, size_t length, uint64_t seed);
+
+#endif
@@ -0,0 +1,246 @@
+#include "lz4.h"
+#include "string.h"
+
+// format limits: the last 5 bytes are always literals and the last match
+// starts at least 12 bytes before the end
+#define MIN_MATCH 4
+#define LAST_LITERALS 5
+#define MF_LIMIT 12
+#define MAX_OFFSET 65535
+#define RUN_MASK 15
+
+// after 2^SKIP_TRIGGER failed probes the search starts skipping ahead, so
+// incompressible data goes through quickly
+#define SKIP_TRIGGER 6
+
+// copies at least this long go through memcpy, which moves whole words
+// (or vectors) and handles misaligned pointers
+#define WIDE_COPY 16
+
+static inline uint32_t read32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline uint32_t lz4_hash(uint32_t sequence) {
+    return (sequence * 2654435761U) >> (32 - LZ4_HASH_LOG);
+}
+
+static uint8_t* write_length(uint8_t* op, size_t length) {
+    while (length >= 255) {
+        *op++ = 255;
+        length -= 255;
+    }
+    *op++ = (uint8_t)length;
+    return op;
+}
+
+// token, length bytes and literals; the match part is filled in by the caller
+static uint8_t* write_literals(uint8_t* op, const uint8_t* literals, size_t length) {
+    uint8_t* token = op++;
+    if (length >= RUN_MASK) {
+        *token = RUN_MASK << 4;
+        op = write_length(op, length - RUN_MASK);
+    } else {
+        *token = (uint8_t)(length << 4);
+    }
+    memcpy(op, literals, length);
+    return op + length;
+}
+
+int lz4_compress(const void* src, size_t src_size, void* dst, size_t dst_capacity,
+                 lz4_table_t* table) {
+    if (src_size > LZ4_MAX_INPUT_SIZE) {
+        return LZ4_ERROR_INPUT_TOO_LARGE;
+    }
+
+    const uint8_t* base = src;
+    const uint8_t* ip = base;
+    const uint8_t* anchor = base;
+    const uint8_t* iend = base + src_size;
+    uint8_t* op = dst;
+    uint8_t* oend = op + dst_capacity;
+
+    if (src_size > MF_LIMIT) {
+        const uint8_t* mflimit = iend - MF_LIMIT;
+        const uint8_t* matchlimit = iend - LAST_LITERALS;
+
+        // stale positions are harmless (every candidate is verified), but
+        // they must lie inside this input
+        memset(table, 0, sizeof(*table));
+        ip++;
+
+        while (ip <= mflimit) {
+            const uint8_t* ref;
+            uint32_t probes = 1U << SKIP_TRIGGER;
+            for (;;) {
+                uint32_t sequence = read32(ip);
+                uint32_t h = lz4_hash(sequence);
+                ref = base + table->position[h];
+                table->position[h] = (uint32_t)(ip - base);
+                if (ip - ref <= MAX_OFFSET && read32(ref) == sequence) {
+                    break;
+                }
+                ip += probes++ >> SKIP_TRIGGER;
+                if (ip > mflimit) {
+                    goto last_literals;
+                }
+            }
+
+            while (ip > anchor && ref > base && ip[-1] == ref[-1]) {
+                ip--;
+                ref--;
+            }
+
+            const uint8_t* end = ip + MIN_MATCH;
+            const uint8_t* r = ref + MIN_MATCH;
+            while (end < matchlimit && *end == *r) {
+                end++;
+                r++;
+            }
+
+            size_t literals = ip - anchor;
+            size_t match = end - ip - MIN_MATCH;
+            size_t needed = 1 + literals / 255 + 1 + literals + 2 + match / 255 + 1;
+            if ((size_t)(oend - op) < needed) {
+                return LZ4_ERROR_OUTPUT_TOO_SMALL;
+            }
+
+            uint8_t* token = op;
+            op = write_literals(op, anchor, literals);
+            size_t offset = ip - ref;
+            *op++ = (uint8_t)offset;
+            *op++ = (uint8_t)(offset >> 8);
+            if (match >= RUN_MASK) {
+                *token |= RUN_MASK;
+                op = write_length(op, match - RUN_MASK);
+            } else {
+                *token |= (uint8_t)match;
+            }
+
+            ip = anchor = end;
+
+            // the position just before the next search is a likely match
+            if (ip <= mflimit) {
+                table->position[lz4_hash(read32(ip - 2))] = (uint32_t)(ip - 2 - base);
+            }
+        }
+    }
+
+last_literals:;
+    size_t literals = iend - anchor;
+    if ((size_t)(oend - op) < 1 + literals / 255 + 1 + literals) {
+        return LZ4_ERROR_OUTPUT_TOO_SMALL;
+    }
+    op = write_literals(op, anchor, literals);
+    return (int)(op - (uint8_t*)dst);
+}
+
+static inline void copy_bytes(uint8_t* dst, const uint8_t* src, size_t length) {
+    if (length >= WIDE_COPY) {
+        memcpy(dst, src, length);
+        return;
+    }
+    while (length--) {
+        *dst++ = *src++;
+    }
+}
+
+// a match may overlap the bytes it produces, repeating the last offset
+// bytes; after one period is in place the run is extended by copying what
+// is already there, so the copies double in size
+static inline void copy_match(uint8_t* op, size_t offset, size_t length) {
+    const uint8_t* match = op - offset;
+    if (offset >= length) {
+        copy_bytes(op, match, length);
+        return;
+    }
+    if (offset == 1) {
+        memset(op, *match, length);
+        return;
+    }
+
+    copy_bytes(op, match, offset);
+    size_t done = offset;
+    while (done < length) {
+        size_t chunk = (length - done < done) ? length - done : done;
+        copy_bytes(op + done, op, chunk);
+        done += chunk;
+    }
+}
+
+// extra length bytes: keep adding while they are 255
+static int read_length(const uint8_t** ip, const uint8_t* iend, size_t* length) {
+    uint8_t byte;
+    do {
+        if (*ip >= iend) {
+            return LZ4_ERROR_CORRUPT;
+        }
+        byte = *(*ip)++;
+        *length += byte;
+    } while (byte == 255);
+    return 0;
+}
+
+int lz4_decompress(const void* src, size_t src_size, void* dst, size_t dst_capacity) {
+    const uint8_t* ip = src;
+    const uint8_t* iend = ip + src_size;
+    uint8_t* op = dst;
+    uint8_t* oend = op + dst_capacity;
+
+    for (;;) {
+        if (ip >= iend) {
+            return LZ4_ERROR_CORRUPT;
+        }
+        uint8_t token = *ip++;
+
+        size_t length = token >> 4;
+        if (length == RUN_MASK && read_length(&ip, iend, &length) < 0) {
+            return LZ4_ERROR_CORRUPT;
+        }
+        if ((size_t)(iend - ip) < length) {
+            return LZ4_ERROR_CORRUPT;
+        }
+        if ((size_t)(oend - op) < length) {
+            return LZ4_ERROR_OUTPUT_TOO_SMALL;
+        }
+        copy_bytes(op, ip, length);
+        op += length;
+        ip += length;
+
+        // the last sequence stops after its literals
+        if (ip == iend) {
+            break;
+        }
+
+        if (iend - ip < 2) {
+            return LZ4_ERROR_CORRUPT;
+        }
+        size_t offset = ip[0] | ((size_t)ip[1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > (size_t)(op - (uint8_t*)dst)) {
+            return LZ4_ERROR_CORRUPT;
+        }
+
+        length = token & RUN_MASK;
+        if (length == RUN_MASK && read_length(&ip, iend, &length) < 0) {
+            return LZ4_ERROR_CORRUPT;
+        }
+        length += MIN_MATCH;
+        if ((size_t)(oend - op) < length) {
+            return LZ4_ERROR_OUTPUT_TOO_SMALL;
+        }
+        copy_match(op, offset, length);
+        op += length;
+    }
+
+    return (int)(op - (uint8_t*)dst);
+}
+
+const char* lz4_error_string(int error) {
+    switch (error) {
+        case LZ4_ERROR_OUTPUT_TOO_SMALL: return "Output buffer too small";
+        case LZ4_ERROR_CORRUPT: return "Corrupt input";
+        case LZ4_ERROR_INPUT_TOO_LARGE: return "Input too large";
+        default: return "Unknown error";
+    }
+}
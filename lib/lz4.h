@@ -0,0 +1,37 @@
+#ifndef LZ4_H
+#define LZ4_H
+
+#include "../kernel/include/types.h"
+
+// LZ4 block format (no frame header or checksum), interoperable with
+// LZ4_compress_default() / LZ4_decompress_safe(). Nothing is allocated:
+// the compressor's hash table comes from the caller, and both directions
+// work between caller buffers.
+
+#define LZ4_ERROR_OUTPUT_TOO_SMALL -1
+#define LZ4_ERROR_CORRUPT -2
+#define LZ4_ERROR_INPUT_TOO_LARGE -3
+
+#define LZ4_MAX_INPUT_SIZE 0x7E000000
+
+// 16 KB; too big for the boot stack, so kmalloc it or keep it static
+#define LZ4_HASH_LOG 12
+typedef struct {
+    uint32_t position[1 << LZ4_HASH_LOG];
+} lz4_table_t;
+
+// worst case compressed size, for sizing dst
+#define LZ4_COMPRESS_BOUND(n) ((n) + (n) / 255 + 16)
+
+// returns the compressed size, or LZ4_ERROR_* if dst is too small or the
+// input too large
+int lz4_compress(const void* src, size_t src_size, void* dst, size_t dst_capacity,
+                 lz4_table_t* table);
+
+// returns the decompressed size; malformed input is rejected without
+// reading or writing outside either buffer
+int lz4_decompress(const void* src, size_t src_size, void* dst, size_t dst_capacity);
+
+const char* lz4_error_string(int error);
+
+#endif
@@ -0,0 +1,316 @@
+#include "printf.h"
+#include "../kernel/include/types.h"
+
+#define FLAG_LEFT  0x1
+#define FLAG_ZERO  0x2
+#define FLAG_ALT   0x4
+#define FLAG_PLUS  0x8
+#define FLAG_SPACE 0x10
+
+typedef struct {
+    int flags;
+    int width;
+    int precision;  // -1 if not given
+} spec_t;
+
+static const char digit_pairs[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+static void sink_putc(printf_sink_t* sink, char c) {
+    if (sink->len == sink->size && sink->flush) {
+        sink->flush(sink);
+    }
+    if (sink->len < sink->size) {
+        sink->buf[sink->len++] = c;
+    }
+    sink->total++;
+}
+
+static void sink_write(printf_sink_t* sink, const char* str, size_t len) {
+    while (len > 0) {
+        if (sink->len == sink->size && sink->flush) {
+            sink->flush(sink);
+        }
+        size_t room = sink->size - sink->len;
+        if (room == 0) {
+            // no flush: drop the rest but keep counting
+            sink->total += len;
+            return;
+        }
+        size_t chunk = len < room ? len : room;
+        for (size_t i = 0; i < chunk; i++) {
+            sink->buf[sink->len + i] = str[i];
+        }
+        sink->len += chunk;
+        sink->total += chunk;
+        str += chunk;
+        len -= chunk;
+    }
+}
+
+static void sink_fill(printf_sink_t* sink, char c, int count) {
+    while (count-- > 0) {
+        sink_putc(sink, c);
+    }
+}
+
+// digits are written backwards, ending at end; returns the first one
+static char* format_decimal(char* end, uint64_t value) {
+    while (value >= 100) {
+        unsigned int pair = (unsigned int)(value % 100) * 2;
+        value /= 100;
+        *--end = digit_pairs[pair + 1];
+        *--end = digit_pairs[pair];
+    }
+    if (value >= 10) {
+        *--end = digit_pairs[value * 2 + 1];
+        *--end = digit_pairs[value * 2];
+    } else {
+        *--end = (char)('0' + value);
+    }
+    return end;
+}
+
+static char* format_hex(char* end, uint64_t value, int upper) {
+    const char* digits = upper ? "0123456789ABCDEF" : "0123456789abcdef";
+    do {
+        *--end = digits[value & 0xF];
+        value >>= 4;
+    } while (value);
+    return end;
+}
+
+// prefix, zeros up to the precision, digits; padded to the width
+static void emit_number(printf_sink_t* sink, const spec_t* spec, const char* prefix,
+                        const char* digits, int len) {
+    int prefix_len = 0;
+    while (prefix[prefix_len]) {
+        prefix_len++;
+    }
+
+    int zeros = spec->precision > len ? spec->precision - len : 0;
+    int pad = spec->width - (prefix_len + zeros + len);
+    if (pad < 0) {
+        pad = 0;
+    }
+
+    if ((spec->flags & FLAG_ZERO) && !(spec->flags & FLAG_LEFT) && spec->precision < 0) {
+        zeros += pad;
+        pad = 0;
+    }
+
+    if (!(spec->flags & FLAG_LEFT)) {
+        sink_fill(sink, ' ', pad);
+    }
+    sink_write(sink, prefix, prefix_len);
+    sink_fill(sink, '0', zeros);
+    sink_write(sink, digits, len);
+    if (spec->flags & FLAG_LEFT) {
+        sink_fill(sink, ' ', pad);
+    }
+}
+
+static void emit_string(printf_sink_t* sink, const spec_t* spec, const char* str) {
+    if (!str) {
+        str = "(null)";
+    }
+    int len = 0;
+    while (str[len] && (spec->precision < 0 || len < spec->precision)) {
+        len++;
+    }
+
+    int pad = spec->width > len ? spec->width - len : 0;
+    if (!(spec->flags & FLAG_LEFT)) {
+        sink_fill(sink, ' ', pad);
+    }
+    sink_write(sink, str, len);
+    if (spec->flags & FLAG_LEFT) {
+        sink_fill(sink, ' ', pad);
+    }
+}
+
+int kvformat(printf_sink_t* sink, const char* fmt, va_list args) {
+    while (*fmt) {
+        // copy literal text up to the next conversion in one go
+        const char* run = fmt;
+        while (*fmt && *fmt != '%') {
+            fmt++;
+        }
+        if (fmt != run) {
+            sink_write(sink, run, fmt - run);
+            continue;
+        }
+        fmt++;
+
+        spec_t spec = { 0, 0, -1 };
+        for (;; fmt++) {
+            if (*fmt == '-') {
+                spec.flags |= FLAG_LEFT;
+            } else if (*fmt == '0') {
+                spec.flags |= FLAG_ZERO;
+            } else if (*fmt == '#') {
+                spec.flags |= FLAG_ALT;
+            } else if (*fmt == '+') {
+                spec.flags |= FLAG_PLUS;
+            } else if (*fmt == ' ') {
+                spec.flags |= FLAG_SPACE;
+            } else {
+                break;
+            }
+        }
+
+        if (*fmt == '*') {
+            spec.width = va_arg(args, int);
+            if (spec.width < 0) {
+                spec.flags |= FLAG_LEFT;
+                spec.width = -spec.width;
+            }
+            fmt++;
+        } else {
+            while (*fmt >= '0' && *fmt <= '9') {
+                spec.width = spec.width * 10 + (*fmt++ - '0');
+            }
+        }
+
+        if (*fmt == '.') {
+            fmt++;
+            spec.precision = 0;
+            if (*fmt == '*') {
+                spec.precision = va_arg(args, int);
+                fmt++;
+            } else {
+                while (*fmt >= '0' && *fmt <= '9') {
+                    spec.precision = spec.precision * 10 + (*fmt++ - '0');
+                }
+            }
+        }
+
+        // hh and h still read an int; the value is narrowed below
+        int longs = 0;
+        int shorts = 0;
+        for (;; fmt++) {
+            if (*fmt == 'l' || *fmt == 'z') {
+                longs++;
+            } else if (*fmt == 'h') {
+                shorts++;
+            } else {
+                break;
+            }
+        }
+
+        char digits[24];
+        char* end = digits + sizeof(digits);
+        char* start;
+        char conv = *fmt;
+        if (conv == '\0') {
+            break;
+        }
+        fmt++;
+
+        switch (conv) {
+            case 'd':
+            case 'i': {
+                int64_t value = longs ? va_arg(args, long) : va_arg(args, int);
+                if (shorts == 1) {
+                    value = (short)value;
+                } else if (shorts > 1) {
+                    value = (signed char)value;
+                }
+                uint64_t magnitude = value < 0 ? 0 - (uint64_t)value : (uint64_t)value;
+                start = format_decimal(end, magnitude);
+                if (spec.precision == 0 && value == 0) {
+                    start = end;
+                }
+                // '+' wins over ' ' when both are given
+                const char* sign = "";
+                if (value < 0) {
+                    sign = "-";
+                } else if (spec.flags & FLAG_PLUS) {
+                    sign = "+";
+                } else if (spec.flags & FLAG_SPACE) {
+                    sign = " ";
+                }
+                emit_number(sink, &spec, sign, start, end - start);
+                break;
+            }
+            case 'u':
+            case 'x':
+            case 'X': {
+                uint64_t value = longs ? va_arg(args, unsigned long) : va_arg(args, unsigned int);
+                if (shorts == 1) {
+                    value = (unsigned short)value;
+                } else if (shorts > 1) {
+                    value = (unsigned char)value;
+                }
+                start = conv == 'u' ? format_decimal(end, value)
+                                    : format_hex(end, value, conv == 'X');
+                if (spec.precision == 0 && value == 0) {
+                    start = end;
+                }
+                const char* prefix = "";
+                if ((spec.flags & FLAG_ALT) && conv != 'u' && value != 0) {
+                    prefix = conv == 'X' ? "0X" : "0x";
+                }
+                emit_number(sink, &spec, prefix, start, end - start);
+                break;
+            }
+            case 'p': {
+                uintptr_t value = (uintptr_t)va_arg(args, void*);
+                start = format_hex(end, value, 0);
+                emit_number(sink, &spec, "0x", start, end - start);
+                break;
+            }
+            case 's':
+                emit_string(sink, &spec, va_arg(args, const char*));
+                break;
+            case 'c': {
+                char c = (char)va_arg(args, int);
+                int pad = spec.width > 1 ? spec.width - 1 : 0;
+                if (!(spec.flags & FLAG_LEFT)) {
+                    sink_fill(sink, ' ', pad);
+                }
+                sink_putc(sink, c);
+                if (spec.flags & FLAG_LEFT) {
+                    sink_fill(sink, ' ', pad);
+                }
+                break;
+            }
+            case '%':
+                sink_putc(sink, '%');
+                break;
+            default:
+                // unknown conversion: print it as written
+                sink_putc(sink, '%');
+                sink_putc(sink, conv);
+                break;
+        }
+    }
+
+    return (int)sink->total;
+}
+
+int kvsnprintf(char* buf, size_t size, const char* fmt, va_list args) {
+    printf_sink_t sink = { buf, size ? size - 1 : 0, 0, 0, NULL };
+    int total = kvformat(&sink, fmt, args);
+    if (size) {
+        buf[sink.len] = '\0';
+    }
+    return total;
+}
+
+int ksnprintf(char* buf, size_t size, const char* fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    int total = kvsnprintf(buf, size, fmt, args);
+    va_end(args);
+    return total;
+}
@@ -0,0 +1,33 @@
+#ifndef PRINTF_H
+#define PRINTF_H
+
+#include <stddef.h>
+#include <stdarg.h>
+
+// printf-style formatting in one pass over the format string.
+// Conversions: %d %i %u %x %X %p %s %c %%, with the flags '-' '0' '#'
+// and, for %d and %i, '+' ' '; a width and a precision (either may be
+// '*'); and the length modifiers hh h l ll z. Numbers are formatted as
+// 64-bit values, decimal two digits at a time.
+
+// where formatted text goes: it collects in buf, and flush is called each
+// time buf fills up. With flush NULL, output past size is dropped but still
+// counted, as snprintf does.
+typedef struct printf_sink {
+    char* buf;
+    size_t size;
+    size_t len;
+    size_t total;
+    void (*flush)(struct printf_sink* sink);
+} printf_sink_t;
+
+// returns the number of characters produced; the caller flushes what is
+// left in sink->buf
+int kvformat(printf_sink_t* sink, const char* fmt, va_list args);
+
+// always NUL-terminates when size > 0; returns the untruncated length
+int kvsnprintf(char* buf, size_t size, const char* fmt, va_list args);
+int ksnprintf(char* buf, size_t size, const char* fmt, ...)
+    __attribute__((format(printf, 3, 4)));
+
+#endif
@@ -0,0 +1,682 @@
+#include "regex.h"
+#include "string.h"
+
+// NFA state types; RE_CHAR, RE_CLASS and RE_ANY consume a byte
+enum {
+    RE_CHAR,
+    RE_CLASS,
+    RE_ANY,
+    RE_SPLIT,
+    RE_EMPTY,
+    RE_BOL,
+    RE_EOL,
+    RE_MATCH
+};
+
+#define RE_NONE 0xFFFF
+
+struct regex_state {
+    uint8_t type;
+    uint8_t byte;       // RE_CHAR
+    uint16_t out;
+    uint16_t out1;      // RE_SPLIT second branch, RE_CLASS class index
+};
+
+#define DFA_MATCH        0x1    // a match ends at or before this position
+#define DFA_MATCH_AT_END 0x2    // matches if the text ends here ($)
+
+struct regex_dfa {
+    uint32_t hash;
+    uint8_t flags;
+};
+
+// Thompson construction. A fragment's dangling exits are kept as a list
+// threaded through the unset out fields: entry = state << 1 | (out1 ? 1 : 0)
+typedef struct {
+    uint16_t start;
+    uint16_t out;
+} frag_t;
+
+typedef struct {
+    regex_t* re;
+    const char* p;
+    uint16_t max_states;
+    uint16_t max_classes;
+    int error;
+} parser_t;
+
+static uint16_t* exit_slot(regex_t* re, uint16_t entry) {
+    struct regex_state* s = &re->states[entry >> 1];
+    return (entry & 1) ? &s->out1 : &s->out;
+}
+
+static uint16_t exit_list(regex_t* re, uint16_t state, int second) {
+    uint16_t entry = (uint16_t)(state << 1 | second);
+    *exit_slot(re, entry) = RE_NONE;
+    return entry;
+}
+
+static void patch(regex_t* re, uint16_t list, uint16_t target) {
+    while (list != RE_NONE) {
+        uint16_t* slot = exit_slot(re, list);
+        list = *slot;
+        *slot = target;
+    }
+}
+
+static uint16_t append(regex_t* re, uint16_t a, uint16_t b) {
+    if (a == RE_NONE) {
+        return b;
+    }
+    uint16_t entry = a;
+    while (*exit_slot(re, entry) != RE_NONE) {
+        entry = *exit_slot(re, entry);
+    }
+    *exit_slot(re, entry) = b;
+    return a;
+}
+
+static uint16_t new_state(parser_t* ps, uint8_t type, uint16_t out, uint16_t out1) {
+    regex_t* re = ps->re;
+    if (re->num_states >= ps->max_states) {
+        ps->error = REGEX_ERROR_NO_SPACE;
+        return 0;
+    }
+    struct regex_state* s = &re->states[re->num_states];
+    s->type = type;
+    s->byte = 0;
+    s->out = out;
+    s->out1 = out1;
+    return re->num_states++;
+}
+
+static frag_t single(parser_t* ps, uint8_t type, uint8_t byte, uint16_t cls) {
+    frag_t f = { 0, RE_NONE };
+    uint16_t s = new_state(ps, type, RE_NONE, cls);
+    if (ps->error) {
+        return f;
+    }
+    ps->re->states[s].byte = byte;
+    f.start = s;
+    f.out = exit_list(ps->re, s, 0);
+    return f;
+}
+
+static int new_class(parser_t* ps) {
+    regex_t* re = ps->re;
+    if (re->num_classes >= ps->max_classes) {
+        ps->error = REGEX_ERROR_NO_SPACE;
+        return -1;
+    }
+    memset(re->classes[re->num_classes], 0, sizeof(re->classes[0]));
+    return re->num_classes++;
+}
+
+static void set_range(uint64_t* set, unsigned int lo, unsigned int hi) {
+    for (unsigned int c = lo; c <= hi; c++) {
+        set[c >> 6] |= (uint64_t)1 << (c & 63);
+    }
+}
+
+static int set_has(const uint64_t* set, unsigned int c) {
+    return (set[c >> 6] >> (c & 63)) & 1;
+}
+
+// \d \w \s and their negations; 0 if e is not one of them
+static int add_escape_class(uint64_t* set, char e) {
+    uint64_t tmp[4] = { 0, 0, 0, 0 };
+
+    switch (e | 0x20) {
+        case 'd':
+            set_range(tmp, '0', '9');
+            break;
+        case 'w':
+            set_range(tmp, '0', '9');
+            set_range(tmp, 'a', 'z');
+            set_range(tmp, 'A', 'Z');
+            set_range(tmp, '_', '_');
+            break;
+        case 's':
+            set_range(tmp, '\t', '\r');
+            set_range(tmp, ' ', ' ');
+            break;
+        default:
+            return 0;
+    }
+
+    int negate = (e >= 'A' && e <= 'Z');
+    for (int i = 0; i < 4; i++) {
+        set[i] |= negate ? ~tmp[i] : tmp[i];
+    }
+    return 1;
+}
+
+static uint8_t escape_byte(char e) {
+    switch (e) {
+        case 't': return '\t';
+        case 'n': return '\n';
+        case 'r': return '\r';
+        default:  return (uint8_t)e;
+    }
+}
+
+// one member of a bracket expression; returns the byte, or -1 if it was a
+// class escape that has already been added to the set
+static int class_member(parser_t* ps, uint64_t* set) {
+    char c = *ps->p++;
+    if (c == '\\') {
+        c = *ps->p++;
+        if (c == '\0') {
+            ps->error = REGEX_ERROR_SYNTAX;
+            return -1;
+        }
+        if (add_escape_class(set, c)) {
+            return -1;
+        }
+        return escape_byte(c);
+    }
+    return (uint8_t)c;
+}
+
+static frag_t parse_bracket(parser_t* ps) {
+    frag_t f = { 0, RE_NONE };
+    int cls = new_class(ps);
+    if (cls < 0) {
+        return f;
+    }
+    uint64_t* set = ps->re->classes[cls];
+
+    int negate = 0;
+    if (*ps->p == '^') {
+        negate = 1;
+        ps->p++;
+    }
+
+    // a ']' right after the opening bracket is a literal
+    int first = 1;
+    while (*ps->p && (*ps->p != ']' || first)) {
+        first = 0;
+        int lo = class_member(ps, set);
+        if (ps->error) {
+            return f;
+        }
+        if (lo < 0) {
+            continue;
+        }
+        if (ps->p[0] == '-' && ps->p[1] && ps->p[1] != ']') {
+            ps->p++;
+            int hi = class_member(ps, set);
+            if (ps->error || hi < lo) {
+                ps->error = REGEX_ERROR_SYNTAX;
+                return f;
+            }
+            set_range(set, lo, hi);
+        } else {
+            set_range(set, lo, lo);
+        }
+    }
+
+    if (*ps->p != ']') {
+        ps->error = REGEX_ERROR_SYNTAX;
+        return f;
+    }
+    ps->p++;
+
+    if (negate) {
+        for (int i = 0; i < 4; i++) {
+            set[i] = ~set[i];
+        }
+    }
+    return single(ps, RE_CLASS, 0, cls);
+}
+
+static frag_t parse_alternation(parser_t* ps);
+
+static frag_t parse_atom(parser_t* ps) {
+    frag_t f = { 0, RE_NONE };
+    char c = *ps->p++;
+
+    switch (c) {
+        case '(':
+            f = parse_alternation(ps);
+            if (ps->error) {
+                return f;
+            }
+            if (*ps->p != ')') {
+                ps->error = REGEX_ERROR_SYNTAX;
+                return f;
+            }
+            ps->p++;
+            return f;
+        case '*':
+        case '+':
+        case '?':
+            ps->error = REGEX_ERROR_SYNTAX;
+            return f;
+        case '.':
+            return single(ps, RE_ANY, 0, 0);
+        case '^':
+            return single(ps, RE_BOL, 0, 0);
+        case '$':
+            return single(ps, RE_EOL, 0, 0);
+        case '[':
+            return parse_bracket(ps);
+        case '\\': {
+            char e = *ps->p++;
+            if (e == '\0') {
+                ps->error = REGEX_ERROR_SYNTAX;
+                return f;
+            }
+            if ((e | 0x20) == 'd' || (e | 0x20) == 'w' || (e | 0x20) == 's') {
+                int cls = new_class(ps);
+                if (cls < 0) {
+                    return f;
+                }
+                add_escape_class(ps->re->classes[cls], e);
+                return single(ps, RE_CLASS, 0, cls);
+            }
+            return single(ps, RE_CHAR, escape_byte(e), 0);
+        }
+        default:
+            return single(ps, RE_CHAR, (uint8_t)c, 0);
+    }
+}
+
+static frag_t parse_repeat(parser_t* ps) {
+    frag_t f = parse_atom(ps);
+
+    while (!ps->error && (*ps->p == '*' || *ps->p == '+' || *ps->p == '?')) {
+        char op = *ps->p++;
+        uint16_t s = new_state(ps, RE_SPLIT, f.start, RE_NONE);
+        if (ps->error) {
+            break;
+        }
+        if (op == '*') {
+            patch(ps->re, f.out, s);
+            f.start = s;
+            f.out = exit_list(ps->re, s, 1);
+        } else if (op == '+') {
+            patch(ps->re, f.out, s);
+            f.out = exit_list(ps->re, s, 1);
+        } else {
+            f.start = s;
+            f.out = append(ps->re, f.out, exit_list(ps->re, s, 1));
+        }
+    }
+    return f;
+}
+
+static frag_t parse_concat(parser_t* ps) {
+    frag_t f = { 0, RE_NONE };
+    int empty = 1;
+
+    while (*ps->p && *ps->p != '|' && *ps->p != ')') {
+        frag_t next = parse_repeat(ps);
+        if (ps->error) {
+            return f;
+        }
+        if (empty) {
+            f = next;
+            empty = 0;
+        } else {
+            patch(ps->re, f.out, next.start);
+            f.out = next.out;
+        }
+    }
+
+    if (empty) {
+        f = single(ps, RE_EMPTY, 0, 0);
+    }
+    return f;
+}
+
+static frag_t parse_alternation(parser_t* ps) {
+    frag_t f = parse_concat(ps);
+
+    while (!ps->error && *ps->p == '|') {
+        ps->p++;
+        frag_t other = parse_concat(ps);
+        if (ps->error) {
+            break;
+        }
+        uint16_t s = new_state(ps, RE_SPLIT, f.start, other.start);
+        if (ps->error) {
+            break;
+        }
+        f.start = s;
+        f.out = append(ps->re, f.out, other.out);
+    }
+    return f;
+}
+
+static int state_matches(const regex_t* re, const struct regex_state* s, uint8_t byte) {
+    switch (s->type) {
+        case RE_CHAR:  return s->byte == byte;
+        case RE_ANY:   return byte != '\n';
+        case RE_CLASS: return set_has(re->classes[s->out1], byte);
+        default:       return 0;
+    }
+}
+
+static int is_consuming(const struct regex_state* s) {
+    return s->type == RE_CHAR || s->type == RE_CLASS || s->type == RE_ANY;
+}
+
+// bytes that every consuming state treats alike share a class, so a DFA
+// state needs one transition per class rather than 256
+static void build_byte_classes(regex_t* re, uint16_t* remap) {
+    uint16_t count = 1;
+    memset(re->byte_class, 0, 256);
+
+    for (uint16_t i = 0; i < re->num_states; i++) {
+        const struct regex_state* s = &re->states[i];
+        if (!is_consuming(s)) {
+            continue;
+        }
+
+        // remap[k] for bytes of class k outside s, remap[256 + k] inside
+        memset(remap, 0xFF, 512 * sizeof(uint16_t));
+        count = 0;
+        for (unsigned int b = 0; b < 256; b++) {
+            uint16_t* next = &remap[(state_matches(re, s, b) ? 256 : 0) + re->byte_class[b]];
+            if (*next == RE_NONE) {
+                *next = count++;
+            }
+            re->byte_class[b] = (uint8_t)*next;
+        }
+    }
+
+    re->num_byte_classes = count;
+    for (int b = 255; b >= 0; b--) {
+        re->class_byte[re->byte_class[b]] = (uint8_t)b;
+    }
+}
+
+static void set_clear(const regex_t* re, uint64_t* set) {
+    memset(set, 0, re->set_words * sizeof(uint64_t));
+}
+
+// epsilon closure of from, added to set; ^ and $ are only crossed when the
+// position is at that end of the text
+static void closure(regex_t* re, uint64_t* set, uint16_t from, int bol, int eol) {
+    uint16_t* stack = re->stack;
+    int top = 0;
+
+    stack[top++] = from;
+    while (top > 0) {
+        uint16_t i = stack[--top];
+        if (i == RE_NONE || set_has(set, i)) {
+            continue;
+        }
+        set[i >> 6] |= (uint64_t)1 << (i & 63);
+
+        const struct regex_state* s = &re->states[i];
+        switch (s->type) {
+            case RE_SPLIT:
+                stack[top++] = s->out1;
+                stack[top++] = s->out;
+                break;
+            case RE_EMPTY:
+                stack[top++] = s->out;
+                break;
+            case RE_BOL:
+                if (bol) {
+                    stack[top++] = s->out;
+                }
+                break;
+            case RE_EOL:
+                if (eol) {
+                    stack[top++] = s->out;
+                }
+                break;
+        }
+    }
+}
+
+static uint32_t set_hash(const regex_t* re, const uint64_t* set) {
+    uint32_t hash = 2166136261u;
+    for (uint16_t i = 0; i < re->set_words; i++) {
+        hash = (hash ^ (uint32_t)set[i] ^ (uint32_t)(set[i] >> 32)) * 16777619u;
+    }
+    return hash;
+}
+
+static void dfa_flush(regex_t* re) {
+    re->dfa_count = 0;
+    re->start_line = -1;
+    re->flushes++;
+}
+
+// cached DFA state for an NFA state set (already masked to the important
+// states), adding it if needed; a full cache is flushed first
+static int dfa_add(regex_t* re, const uint64_t* set) {
+    uint16_t words = re->set_words;
+    uint32_t hash = set_hash(re, set);
+
+    for (uint16_t i = 0; i < re->dfa_count; i++) {
+        if (re->dfa[i].hash == hash &&
+            memcmp(&re->dfa_sets[i * words], set, words * sizeof(uint64_t)) == 0) {
+            return i;
+        }
+    }
+
+    if (re->dfa_count == re->dfa_capacity) {
+        dfa_flush(re);
+    }
+
+    uint16_t index = re->dfa_count++;
+    struct regex_dfa* dfa = &re->dfa[index];
+    memcpy(&re->dfa_sets[index * words], set, words * sizeof(uint64_t));
+    memset(&re->dfa_next[index * re->num_byte_classes], 0,
+           re->num_byte_classes * sizeof(uint16_t));
+    dfa->hash = hash;
+    dfa->flags = 0;
+
+    // RE_MATCH is always the last state
+    uint16_t match = re->num_states - 1;
+    if (set_has(set, match)) {
+        dfa->flags |= DFA_MATCH;
+    }
+
+    uint64_t* end = re->scratch_set + words;
+    set_clear(re, end);
+    for (uint16_t i = 0; i < re->num_states; i++) {
+        if (set_has(set, i) && re->states[i].type == RE_EOL) {
+            closure(re, end, i, 0, 1);
+        }
+    }
+    if (set_has(end, match)) {
+        dfa->flags |= DFA_MATCH_AT_END;
+    }
+    return index;
+}
+
+static void set_mask(const regex_t* re, uint64_t* set) {
+    for (uint16_t i = 0; i < re->set_words; i++) {
+        set[i] &= re->important[i];
+    }
+}
+
+static int start_state(regex_t* re) {
+    if (re->start_line < 0) {
+        uint64_t* set = re->scratch_set;
+        set_clear(re, set);
+        closure(re, set, re->start, 1, 0);
+        set_mask(re, set);
+        re->start_line = dfa_add(re, set);
+    }
+    return re->start_line;
+}
+
+static int dfa_step(regex_t* re, int from, uint8_t byte_class) {
+    uint16_t* next = &re->dfa_next[from * re->num_byte_classes + byte_class];
+    if (*next) {
+        return *next - 1;
+    }
+
+    uint8_t byte = re->class_byte[byte_class];
+    const uint64_t* src = &re->dfa_sets[from * re->set_words];
+    uint64_t* set = re->scratch_set;
+    set_clear(re, set);
+
+    for (uint16_t i = 0; i < re->num_states; i++) {
+        if (src[i >> 6] == 0) {
+            i |= 63;
+            continue;
+        }
+        const struct regex_state* s = &re->states[i];
+        if (set_has(src, i) && state_matches(re, s, byte)) {
+            closure(re, set, s->out, 0, 0);
+        }
+    }
+    set_mask(re, set);
+
+    // unanchored search: a match may also start at the next position
+    for (uint16_t i = 0; i < re->set_words; i++) {
+        set[i] |= re->restart[i];
+    }
+
+    uint32_t flushes = re->flushes;
+    int to = dfa_add(re, set);
+    if (re->flushes == flushes) {
+        re->dfa_next[from * re->num_byte_classes + byte_class] = to + 1;
+    }
+    return to;
+}
+
+// carve an 8-byte aligned block off the front of the workspace
+static void* carve(uint8_t** work, size_t* left, size_t size) {
+    size_t pad = (8 - ((uintptr_t)*work & 7)) & 7;
+    if (pad + size > *left) {
+        return NULL;
+    }
+    void* block = *work + pad;
+    *work += pad + size;
+    *left -= pad + size;
+    return block;
+}
+
+int regex_compile(regex_t* re, const char* pattern, void* work, size_t work_size) {
+    size_t length = strlen(pattern);
+    if (length > REGEX_MAX_PATTERN) {
+        return REGEX_ERROR_TOO_LONG;
+    }
+
+    memset(re, 0, sizeof(regex_t));
+    uint8_t* next = (uint8_t*)work;
+    size_t left = work_size;
+
+    // every byte adds at most one state plus one for an empty branch, and
+    // only '[' and '\' can start a class
+    parser_t ps = { re, pattern, (uint16_t)(2 * length + 2), 1, REGEX_OK };
+    for (size_t i = 0; i < length; i++) {
+        if (pattern[i] == '[' || pattern[i] == '\\') {
+            ps.max_classes++;
+        }
+    }
+
+    re->states = carve(&next, &left, ps.max_states * sizeof(struct regex_state));
+    re->classes = carve(&next, &left, ps.max_classes * sizeof(re->classes[0]));
+    re->byte_class = carve(&next, &left, 256);
+    re->class_byte = carve(&next, &left, 256);
+    if (!re->states || !re->classes || !re->byte_class || !re->class_byte) {
+        return REGEX_ERROR_NO_SPACE;
+    }
+
+    frag_t f = parse_alternation(&ps);
+    if (!ps.error && *ps.p != '\0') {
+        ps.error = REGEX_ERROR_SYNTAX;     // unbalanced ')'
+    }
+    if (ps.error) {
+        return ps.error;
+    }
+    uint16_t match = new_state(&ps, RE_MATCH, RE_NONE, RE_NONE);
+    if (ps.error) {
+        return ps.error;
+    }
+    patch(re, f.out, match);
+    re->start = f.start;
+
+    re->set_words = (re->num_states + 63) / 64;
+    size_t set_bytes = re->set_words * sizeof(uint64_t);
+    re->important = carve(&next, &left, set_bytes);
+    re->restart = carve(&next, &left, set_bytes);
+    re->scratch_set = carve(&next, &left, 2 * set_bytes);
+    re->stack = carve(&next, &left, (2 * re->num_states + 1) * sizeof(uint16_t));
+    if (!re->important || !re->restart || !re->scratch_set || !re->stack) {
+        return REGEX_ERROR_NO_SPACE;
+    }
+
+    // byte classes need a temporary table; borrow what becomes the cache
+    uint16_t* remap = carve(&next, &left, 0);
+    if (!remap || left < 512 * sizeof(uint16_t)) {
+        return REGEX_ERROR_NO_SPACE;
+    }
+    build_byte_classes(re, remap);
+
+    // DFA states are keyed on consuming states, $ and the match state
+    set_clear(re, re->important);
+    for (uint16_t i = 0; i < re->num_states; i++) {
+        const struct regex_state* s = &re->states[i];
+        if (is_consuming(s) || s->type == RE_EOL || s->type == RE_MATCH) {
+            re->important[i >> 6] |= (uint64_t)1 << (i & 63);
+        }
+    }
+
+    // states a match starting after the first byte begins in
+    set_clear(re, re->restart);
+    closure(re, re->restart, re->start, 0, 0);
+    set_mask(re, re->restart);
+
+    size_t per_state = sizeof(struct regex_dfa) + set_bytes +
+                       re->num_byte_classes * sizeof(uint16_t);
+    // less a little for the alignment padding of the three arrays
+    size_t capacity = left > 24 ? (left - 24) / per_state : 0;
+    if (capacity > RE_NONE - 1) {
+        capacity = RE_NONE - 1;
+    }
+    if (capacity < 4) {
+        return REGEX_ERROR_NO_SPACE;
+    }
+    re->dfa_capacity = (uint16_t)capacity;
+    re->dfa = carve(&next, &left, capacity * sizeof(struct regex_dfa));
+    re->dfa_sets = carve(&next, &left, capacity * set_bytes);
+    re->dfa_next = carve(&next, &left, capacity * re->num_byte_classes * sizeof(uint16_t));
+    if (!re->dfa || !re->dfa_sets || !re->dfa_next) {
+        return REGEX_ERROR_NO_SPACE;
+    }
+
+    re->start_line = -1;
+    return REGEX_OK;
+}
+
+int regex_search(regex_t* re, const char* text, size_t length) {
+    // the only position where ^ and $ both hold, so the cached states (which
+    // never cross both) can't answer it
+    if (length == 0) {
+        uint64_t* set = re->scratch_set;
+        set_clear(re, set);
+        closure(re, set, re->start, 1, 1);
+        return set_has(set, re->num_states - 1);
+    }
+
+    int state = start_state(re);
+
+    for (size_t i = 0; i < length; i++) {
+        if (re->dfa[state].flags & DFA_MATCH) {
+            return 1;
+        }
+        state = dfa_step(re, state, re->byte_class[(uint8_t)text[i]]);
+    }
+    return (re->dfa[state].flags & (DFA_MATCH | DFA_MATCH_AT_END)) != 0;
+}
+
+const char* regex_error_string(int error) {
+    switch (error) {
+        case REGEX_OK: return "Success";
+        case REGEX_ERROR_SYNTAX: return "Syntax error";
+        case REGEX_ERROR_NO_SPACE: return "Out of memory";
+        case REGEX_ERROR_TOO_LONG: return "Pattern too long";
+        default: return "Unknown error";
+    }
+}
@@ -0,0 +1,58 @@
+#ifndef REGEX_H
+#define REGEX_H
+
+#include "../kernel/include/types.h"
+
+// extended regular expressions for grep -E: literals, ., [...] and [^...]
+// with ranges, \d \w \s (and \D \W \S), ^ and $, |, (), * + ?.
+// The pattern becomes a Thompson NFA, and searching runs a DFA whose states
+// are built on demand and cached in the caller's workspace. When the cache
+// fills up it is flushed and rebuilt, so memory stays bounded and every
+// search is linear in the text length.
+
+#define REGEX_OK 0
+#define REGEX_ERROR_SYNTAX -1
+#define REGEX_ERROR_NO_SPACE -2
+#define REGEX_ERROR_TOO_LONG -3
+
+#define REGEX_MAX_PATTERN 255
+
+struct regex_state;
+struct regex_dfa;
+
+typedef struct {
+    struct regex_state* states;
+    uint16_t num_states;
+    uint16_t start;
+    uint64_t (*classes)[4];         // byte sets for [...] and \d-style escapes
+    uint16_t num_classes;
+    uint8_t* byte_class;            // byte -> equivalence class of the pattern
+    uint16_t num_byte_classes;
+    uint8_t* class_byte;            // one representative byte per class
+    uint16_t set_words;             // 64-bit words per NFA state set
+    uint64_t* important;            // states a DFA state is keyed on
+    uint64_t* restart;              // where a match starting mid-text begins
+    uint64_t* scratch_set;
+    uint16_t* stack;
+
+    // DFA cache
+    struct regex_dfa* dfa;
+    uint64_t* dfa_sets;
+    uint16_t* dfa_next;             // 0 = not built yet, else state + 1
+    uint16_t dfa_capacity;
+    uint16_t dfa_count;
+    int32_t start_line;             // cached start state, -1 if not built
+    uint32_t flushes;
+} regex_t;
+
+// work holds the NFA and the DFA cache and must outlive re; a few KB is
+// plenty for a shell-sized pattern
+int regex_compile(regex_t* re, const char* pattern, void* work, size_t work_size);
+
+// 1 if the pattern matches anywhere in the line, 0 if not; ^ and $ anchor
+// to the ends of text
+int regex_search(regex_t* re, const char* text, size_t length);
+
+const char* regex_error_string(int error);
+
+#endif
@@ -1,24 +1,405 @@
 #include "string.h"
 #include "../kernel/include/types.h"
 
+// word-at-a-time helpers: dest is aligned first, and a source that can't be
+// aligned with it is read as aligned words merged with shifts (little endian)
+typedef uint64_t __attribute__((may_alias)) word_t;
+#define WORD_SIZE sizeof(word_t)
+#define WORD_MASK (WORD_SIZE - 1)
+#define ONES ((word_t)0x0101010101010101UL)
+
+static void* memset_scalar(void* ptr, int value, unsigned long num);
+static void* memcpy_scalar(void* dest, const void* src, unsigned long num);
+static int memcmp_scalar(const void* ptr1, const void* ptr2, unsigned long num);
+static void* memchr_scalar(const void* ptr, int value, unsigned long num);
+static unsigned long strlen_scalar(const char* str);
+static char* strchr_scalar(const char* str, int c);
+static int strcmp_scalar(const char* str1, const char* str2);
+static int strncmp_scalar(const char* str1, const char* str2, unsigned long n);
+
+#ifdef __riscv
+static unsigned long strlen_zbb(const char* str);
+static int strcmp_zbb(const char* str1, const char* str2);
+static int strncmp_zbb(const char* str1, const char* str2, unsigned long n);
+
+// RVV versions in string_rvv.s
+void* memset_rvv(void* ptr, int value, unsigned long num);
+void* memcpy_rvv(void* dest, const void* src, unsigned long num);
+int memcmp_rvv(const void* ptr1, const void* ptr2, unsigned long num);
+void* memchr_rvv(const void* ptr, int value, unsigned long num);
+unsigned long strlen_rvv(const char* str);
+char* strchr_rvv(const char* str, int c);
+#endif
+
+// routines with more than one implementation, picked once at boot
+typedef struct {
+    const char* name;
+    void* (*memset)(void* ptr, int value, unsigned long num);
+    void* (*memcpy)(void* dest, const void* src, unsigned long num);
+    int (*memcmp)(const void* ptr1, const void* ptr2, unsigned long num);
+    void* (*memchr)(const void* ptr, int value, unsigned long num);
+    unsigned long (*strlen)(const char* str);
+    char* (*strchr)(const char* str, int c);
+    int (*strcmp)(const char* str1, const char* str2);
+    int (*strncmp)(const char* str1, const char* str2, unsigned long n);
+} string_ops_t;
+
+// scalar until string_init() runs, so early boot code is safe
+static string_ops_t string_ops = {
+    "scalar", memset_scalar, memcpy_scalar, memcmp_scalar,
+    memchr_scalar, strlen_scalar, strchr_scalar,
+    strcmp_scalar, strncmp_scalar
+};
+
+// for STRING_FEATURE_VECTOR the caller must have enabled the vector unit
+// (mstatus.VS) first; the vector strlen wins over the Zbb one
+void string_init(unsigned int features) {
+#ifdef __riscv
+    if (features & STRING_FEATURE_ZBB) {
+        string_ops.name = "Zbb";
+        string_ops.strlen = strlen_zbb;
+        string_ops.strcmp = strcmp_zbb;
+        string_ops.strncmp = strncmp_zbb;
+    }
+    if (features & STRING_FEATURE_VECTOR) {
+        string_ops.name = (features & STRING_FEATURE_ZBB) ? "RVV+Zbb" : "RVV";
+        string_ops.memset = memset_rvv;
+        string_ops.memcpy = memcpy_rvv;
+        string_ops.memcmp = memcmp_rvv;
+        string_ops.memchr = memchr_rvv;
+        string_ops.strlen = strlen_rvv;
+        string_ops.strchr = strchr_rvv;
+    }
+#else
+    (void)features;   // host builds (tools/) only have the scalar code
+#endif
+}
+
+#ifdef __riscv
+// Zbb through .insn, so only these routines need the extension; orc.b turns
+// every non-zero byte into 0xff and every zero byte into 0x00
+static inline word_t orc_b(word_t x) {
+    word_t result;
+    asm (".insn i 0x13, 0x5, %0, %1, 0x287" : "=r" (result) : "r" (x));
+    return result;
+}
+
+static inline unsigned int ctz(word_t x) {
+    word_t result;
+    asm (".insn i 0x13, 0x1, %0, %1, 0x601" : "=r" (result) : "r" (x));
+    return result;
+}
+
+// difference of the first byte where a and b differ or a has its NUL
+static inline int word_diff(word_t a, word_t b) {
+    unsigned int shift = ctz((a ^ b) | ~orc_b(a)) & ~7U;
+    return (int)((a >> shift) & 0xff) - (int)((b >> shift) & 0xff);
+}
+
+// aligned loads never leave the word holding the terminator
+static unsigned long strlen_zbb(const char* str) {
+    uintptr_t offset = (uintptr_t)str & WORD_MASK;
+    const word_t* w = (const word_t*)(str - offset);
+    
+    // bytes before str count as non-zero
+    word_t x = orc_b(*w) | (((word_t)1 << (offset * 8)) - 1);
+    while (x == ~(word_t)0) {
+        x = orc_b(*++w);
+    }
+    return (const char*)w + (ctz(~x) >> 3) - str;
+}
+
+static int strcmp_zbb(const char* str1, const char* str2) {
+    // words only line up when both strings share an alignment
+    if (((uintptr_t)str1 ^ (uintptr_t)str2) & WORD_MASK) {
+        return strcmp_scalar(str1, str2);
+    }
+    
+    while ((uintptr_t)str1 & WORD_MASK) {
+        if (*str1 == '\0' || *str1 != *str2) {
+            return *(unsigned char*)str1 - *(unsigned char*)str2;
+        }
+        str1++;
+        str2++;
+    }
+    
+    const word_t* a = (const word_t*)str1;
+    const word_t* b = (const word_t*)str2;
+    while (*a == *b && orc_b(*a) == ~(word_t)0) {
+        a++;
+        b++;
+    }
+    return word_diff(*a, *b);
+}
+
+static int strncmp_zbb(const char* str1, const char* str2, unsigned long n) {
+    if (((uintptr_t)str1 ^ (uintptr_t)str2) & WORD_MASK) {
+        return strncmp_scalar(str1, str2, n);
+    }
+    
+    while (n && ((uintptr_t)str1 & WORD_MASK)) {
+        if (*str1 == '\0' || *str1 != *str2) {
+            return *(unsigned char*)str1 - *(unsigned char*)str2;
+        }
+        str1++;
+        str2++;
+        n--;
+    }
+    
+    const word_t* a = (const word_t*)str1;
+    const word_t* b = (const word_t*)str2;
+    while (n >= WORD_SIZE) {
+        if (*a != *b || orc_b(*a) != ~(word_t)0) {
+            return word_diff(*a, *b);
+        }
+        a++;
+        b++;
+        n -= WORD_SIZE;
+    }
+    return strncmp_scalar((const char*)a, (const char*)b, n);
+}
+#endif
+
+const char* string_impl_name(void) {
+    return string_ops.name;
+}
+
 void* memset(void* ptr, int value, unsigned long num) {
+    return string_ops.memset(ptr, value, num);
+}
+
+void* memcpy(void* dest, const void* src, unsigned long num) {
+    return string_ops.memcpy(dest, src, num);
+}
+
+int memcmp(const void* ptr1, const void* ptr2, unsigned long num) {
+    return string_ops.memcmp(ptr1, ptr2, num);
+}
+
+void* memchr(const void* ptr, int value, unsigned long num) {
+    return string_ops.memchr(ptr, value, num);
+}
+
+unsigned long strlen(const char* str) {
+    return string_ops.strlen(str);
+}
+
+char* strchr(const char* str, int c) {
+    return string_ops.strchr(str, c);
+}
+
+int strcmp(const char* str1, const char* str2) {
+    return string_ops.strcmp(str1, str2);
+}
+
+int strncmp(const char* str1, const char* str2, unsigned long n) {
+    return string_ops.strncmp(str1, str2, n);
+}
+
+static void* memset_scalar(void* ptr, int value, unsigned long num) {
     unsigned char* p = (unsigned char*)ptr;
-    for (unsigned long i = 0; i < num; i++) {
-        p[i] = (unsigned char)value;
+    unsigned char byte = (unsigned char)value;
+    
+    while (num && ((uintptr_t)p & WORD_MASK)) {
+        *p++ = byte;
+        num--;
+    }
+    
+    word_t pattern = ONES * byte;
+    word_t* w = (word_t*)p;
+    while (num >= 4 * WORD_SIZE) {
+        w[0] = pattern;
+        w[1] = pattern;
+        w[2] = pattern;
+        w[3] = pattern;
+        w += 4;
+        num -= 4 * WORD_SIZE;
+    }
+    while (num >= WORD_SIZE) {
+        *w++ = pattern;
+        num -= WORD_SIZE;
+    }
+    
+    p = (unsigned char*)w;
+    while (num--) {
+        *p++ = byte;
     }
     return ptr;
 }
 
-void* memcpy(void* dest, const void* src, unsigned long num) {
+static void* memcpy_scalar(void* dest, const void* src, unsigned long num) {
     unsigned char* d = (unsigned char*)dest;
     const unsigned char* s = (const unsigned char*)src;
-    for (unsigned long i = 0; i < num; i++) {
-        d[i] = s[i];
+    
+    while (num && ((uintptr_t)d & WORD_MASK)) {
+        *d++ = *s++;
+        num--;
+    }
+    
+    word_t* wd = (word_t*)d;
+    unsigned int offset = (uintptr_t)s & WORD_MASK;
+    if (offset == 0) {
+        const word_t* ws = (const word_t*)s;
+        while (num >= 4 * WORD_SIZE) {
+            word_t w0 = ws[0], w1 = ws[1], w2 = ws[2], w3 = ws[3];
+            wd[0] = w0;
+            wd[1] = w1;
+            wd[2] = w2;
+            wd[3] = w3;
+            ws += 4;
+            wd += 4;
+            num -= 4 * WORD_SIZE;
+        }
+        while (num >= WORD_SIZE) {
+            *wd++ = *ws++;
+            num -= WORD_SIZE;
+        }
+        s = (const unsigned char*)ws;
+    } else if (num >= WORD_SIZE) {
+        // every load stays inside the aligned word holding a byte we copy
+        unsigned int shift = offset * 8;
+        const word_t* ws = (const word_t*)(s - offset);
+        word_t lo = *ws++;
+        while (num >= WORD_SIZE) {
+            word_t hi = *ws++;
+            *wd++ = (lo >> shift) | (hi << (64 - shift));
+            lo = hi;
+            s += WORD_SIZE;
+            num -= WORD_SIZE;
+        }
+    }
+    
+    d = (unsigned char*)wd;
+    while (num--) {
+        *d++ = *s++;
     }
     return dest;
 }
 
-unsigned long strlen(const char* str) {
+// forward copies are overlap-safe when dest is below src; otherwise copy
+// from the top down with the same word handling as memcpy
+void* memmove(void* dest, const void* src, unsigned long num) {
+    unsigned char* d = (unsigned char*)dest;
+    const unsigned char* s = (const unsigned char*)src;
+    
+    if (d == s || num == 0) {
+        return dest;
+    }
+    if (d < s || d >= s + num) {
+        return memcpy(dest, src, num);
+    }
+    
+    d += num;
+    s += num;
+    while (num && ((uintptr_t)d & WORD_MASK)) {
+        *--d = *--s;
+        num--;
+    }
+    
+    word_t* wd = (word_t*)d;
+    unsigned int offset = (uintptr_t)s & WORD_MASK;
+    if (offset == 0) {
+        const word_t* ws = (const word_t*)s;
+        while (num >= 4 * WORD_SIZE) {
+            word_t w0 = ws[-1], w1 = ws[-2], w2 = ws[-3], w3 = ws[-4];
+            wd[-1] = w0;
+            wd[-2] = w1;
+            wd[-3] = w2;
+            wd[-4] = w3;
+            ws -= 4;
+            wd -= 4;
+            num -= 4 * WORD_SIZE;
+        }
+        while (num >= WORD_SIZE) {
+            *--wd = *--ws;
+            num -= WORD_SIZE;
+        }
+        s = (const unsigned char*)ws;
+    } else if (num >= WORD_SIZE) {
+        unsigned int shift = offset * 8;
+        const word_t* ws = (const word_t*)(s - offset);
+        word_t hi = *ws;
+        while (num >= WORD_SIZE) {
+            word_t lo = *--ws;
+            *--wd = (lo >> shift) | (hi << (64 - shift));
+            hi = lo;
+            s -= WORD_SIZE;
+            num -= WORD_SIZE;
+        }
+    }
+    
+    d = (unsigned char*)wd;
+    while (num--) {
+        *--d = *--s;
+    }
+    return dest;
+}
+
+static int memcmp_scalar(const void* ptr1, const void* ptr2, unsigned long num) {
+    const unsigned char* a = (const unsigned char*)ptr1;
+    const unsigned char* b = (const unsigned char*)ptr2;
+    
+    while (num && ((uintptr_t)a & WORD_MASK)) {
+        if (*a != *b) {
+            return *a - *b;
+        }
+        a++;
+        b++;
+        num--;
+    }
+    
+    // skip equal words; the byte loop below finds the first difference
+    const word_t* wa = (const word_t*)a;
+    unsigned int offset = (uintptr_t)b & WORD_MASK;
+    if (offset == 0) {
+        const word_t* wb = (const word_t*)b;
+        while (num >= WORD_SIZE && *wa == *wb) {
+            wa++;
+            wb++;
+            num -= WORD_SIZE;
+        }
+        b = (const unsigned char*)wb;
+    } else if (num >= WORD_SIZE) {
+        unsigned int shift = offset * 8;
+        const word_t* wb = (const word_t*)(b - offset);
+        word_t lo = *wb++;
+        while (num >= WORD_SIZE) {
+            word_t hi = *wb++;
+            if (*wa != ((lo >> shift) | (hi << (64 - shift)))) {
+                break;
+            }
+            lo = hi;
+            wa++;
+            b += WORD_SIZE;
+            num -= WORD_SIZE;
+        }
+    }
+    
+    a = (const unsigned char*)wa;
+    while (num--) {
+        if (*a != *b) {
+            return *a - *b;
+        }
+        a++;
+        b++;
+    }
+    return 0;
+}
+
+static void* memchr_scalar(const void* ptr, int value, unsigned long num) {
+    const unsigned char* p = (const unsigned char*)ptr;
+    unsigned char byte = (unsigned char)value;
+    
+    while (num--) {
+        if (*p == byte) {
+            return (void*)p;
+        }
+        p++;
+    }
+    return NULL;
+}
+
+static unsigned long strlen_scalar(const char* str) {
     unsigned long len = 0;
     while (str[len] != '\0') {
         len++;
@@ -26,7 +407,7 @@ unsigned long strlen(const char* str) {
     return len;
 }
 
-int strcmp(const char* str1, const char* str2) {
+static int strcmp_scalar(const char* str1, const char* str2) {
     while (*str1 && (*str1 == *str2)) {
         str1++;
         str2++;
@@ -61,29 +442,224 @@ char* strcat(char* dest, const char* src) {
     return original_dest;
 }
 
-char* strstr(const char* haystack, const char* needle) {
-    if (*needle == '\0') {
-        return (char*)haystack;
+char* strncat(char* dest, const char* src, unsigned long n) {
+    char* original_dest = dest;
+    
+    while (*dest != '\0') {
+        dest++;
     }
     
-    while (*haystack != '\0') {
-        const char* h = haystack;
-        const char* n = needle;
-        
-        while (*h == *n && *n != '\0') {
-            h++;
-            n++;
+    while (n-- && *src != '\0') {
+        *dest++ = *src++;
+    }
+    *dest = '\0';
+    return original_dest;
+}
+
+// 256-bit membership set for strspn/strcspn
+static void byte_set_init(uint64_t set[4], const char* chars) {
+    set[0] = set[1] = set[2] = set[3] = 0;
+    for (const unsigned char* c = (const unsigned char*)chars; *c; c++) {
+        set[*c >> 6] |= (uint64_t)1 << (*c & 63);
+    }
+}
+
+static inline int byte_set_has(const uint64_t set[4], unsigned char c) {
+    return (set[c >> 6] >> (c & 63)) & 1;
+}
+
+unsigned long strspn(const char* str1, const char* str2) {
+    uint64_t set[4];
+    byte_set_init(set, str2);
+    
+    const unsigned char* p = (const unsigned char*)str1;
+    while (*p && byte_set_has(set, *p)) {
+        p++;
+    }
+    return p - (const unsigned char*)str1;
+}
+
+unsigned long strcspn(const char* str1, const char* str2) {
+    uint64_t set[4];
+    byte_set_init(set, str2);
+    
+    const unsigned char* p = (const unsigned char*)str1;
+    while (*p && !byte_set_has(set, *p)) {
+        p++;
+    }
+    return p - (const unsigned char*)str1;
+}
+
+// Two-Way string matching (Crochemore-Perrin): the needle is split at a
+// critical factorisation so a mismatch never rescans more than the period,
+// which keeps the worst case linear. On top of that a Horspool table on the
+// last window byte skips ahead without comparing anything, so for typical
+// text the search reads only a fraction of the haystack.
+void str_search_init(str_search_t* search, const void* needle, size_t length) {
+    const unsigned char* n = (const unsigned char*)needle;
+    size_t ip, jp, k, p, ms, p0;
+
+    search->needle = n;
+    search->length = length;
+
+    // skips are capped at 255; a shorter skip is always safe, just slower
+    unsigned char cap = length < 255 ? (unsigned char)length : 255;
+    memset(search->skip, cap, sizeof(search->skip));
+    for (size_t i = 0; i < length; i++) {
+        size_t skip = length - 1 - i;
+        search->skip[n[i]] = skip < 255 ? (unsigned char)skip : 255;
+    }
+
+    // maximal suffix for <, then for >; the later start is the critical point
+    ip = (size_t)-1; jp = 0; k = p = 1;
+    while (jp + k < length) {
+        if (n[ip + k] == n[jp + k]) {
+            if (k == p) {
+                jp += p;
+                k = 1;
+            } else {
+                k++;
+            }
+        } else if (n[ip + k] > n[jp + k]) {
+            jp += k;
+            k = 1;
+            p = jp - ip;
+        } else {
+            ip = jp++;
+            k = p = 1;
         }
-        
-        if (*n == '\0') {
-            return (char*)haystack;
+    }
+    ms = ip;
+    p0 = p;
+
+    ip = (size_t)-1; jp = 0; k = p = 1;
+    while (jp + k < length) {
+        if (n[ip + k] == n[jp + k]) {
+            if (k == p) {
+                jp += p;
+                k = 1;
+            } else {
+                k++;
+            }
+        } else if (n[ip + k] < n[jp + k]) {
+            jp += k;
+            k = 1;
+            p = jp - ip;
+        } else {
+            ip = jp++;
+            k = p = 1;
         }
-        
-        haystack++;
     }
-    
-    return (void*)0;
+    if (ip + 1 > ms + 1) {
+        ms = ip;
+    } else {
+        p = p0;
+    }
+    search->split = ms + 1;
+
+    // a periodic needle shifts by its period and remembers the matched
+    // prefix; otherwise any shift past the critical point is safe
+    if (length == 0 || memcmp(n, n + p, ms + 1) != 0) {
+        size_t right = length - ms - 1;
+        search->period = (ms > right ? ms : right) + 1;
+        search->memory = 0;
+    } else {
+        search->period = p;
+        search->memory = length - p;
+    }
 }
+
+// end is the first byte past the haystack; with terminated set it is only
+// a lower bound and is pushed forward to the NUL as the window needs it
+static const unsigned char* two_way(const str_search_t* search, const unsigned char* h,
+                                    const unsigned char* end, int terminated) {
+    const unsigned char* n = search->needle;
+    size_t length = search->length;
+    size_t split = search->split;
+    size_t mem = 0;
+
+    for (;;) {
+        if ((size_t)(end - h) < length) {
+            if (!terminated) {
+                return NULL;
+            }
+            // bytes past the NUL may not be mapped, so scan one at a time
+            // and stop on it rather than hand memchr a length it could
+            // read past
+            const unsigned char* limit = end + (length | 63);
+            while (end < limit && *end) {
+                end++;
+            }
+            if (end < limit && (size_t)(end - h) < length) {
+                return NULL;
+            }
+        }
+
+        size_t k = search->skip[h[length - 1]];
+        if (k) {
+            h += k < mem ? mem : k;
+            mem = 0;
+            continue;
+        }
+
+        // right half first, then the left half back towards what's known
+        for (k = split > mem ? split : mem; k < length && n[k] == h[k]; k++) {
+        }
+        if (k < length) {
+            h += k - split + 1;
+            mem = 0;
+            continue;
+        }
+        for (k = split; k > mem && n[k - 1] == h[k - 1]; k--) {
+        }
+        if (k <= mem) {
+            return h;
+        }
+        h += search->period;
+        mem = search->memory;
+    }
+}
+
+void* str_search_find(const str_search_t* search, const void* text, size_t length) {
+    if (search->length == 0) {
+        return (void*)text;
+    }
+    if (search->length == 1) {
+        return memchr(text, search->needle[0], length);
+    }
+    const unsigned char* h = (const unsigned char*)text;
+    return (void*)two_way(search, h, h + length, 0);
+}
+
+void* memmem(const void* haystack, size_t haystack_len, const void* needle, size_t needle_len) {
+    if (needle_len > haystack_len) {
+        return NULL;
+    }
+    if (needle_len <= 1) {
+        return needle_len ? memchr(haystack, *(const unsigned char*)needle, haystack_len)
+                          : (void*)haystack;
+    }
+    str_search_t search;
+    str_search_init(&search, needle, needle_len);
+    return (void*)two_way(&search, haystack, (const unsigned char*)haystack + haystack_len, 0);
+}
+
+char* strstr(const char* haystack, const char* needle) {
+    if (*needle == '\0') {
+        return (char*)haystack;
+    }
+
+    // jump to the first candidate before paying for the preprocessing
+    haystack = strchr(haystack, *needle);
+    if (!haystack || !needle[1]) {
+        return (char*)haystack;
+    }
+    str_search_t search;
+    str_search_init(&search, needle, strlen(needle));
+    const unsigned char* h = (const unsigned char*)haystack;
+    return (char*)two_way(&search, h, h, 1);
+}
+
 char* strrchr(const char* str, int c) {
     char* last_occurrence = (void*)0;
     
@@ -101,9 +677,9 @@ char* strrchr(const char* str, int c) {
     return last_occurrence;
 }
 
-char* strchr(const char* str, int c) {
+static char* strchr_scalar(const char* str, int c) {
     while (*str) {
-        if (*str == c) {
+        if (*str == (char)c) {
             return (char*)str;
         }
         str++;
@@ -111,7 +687,7 @@ char* strchr(const char* str, int c) {
     return (c == '\0') ? (char*)str : NULL;
 }
 
-int strncmp(const char* str1, const char* str2, unsigned long n) {
+static int strncmp_scalar(const char* str1, const char* str2, unsigned long n) {
     while (n && *str1 && (*str1 == *str2)) {
         ++str1;
         ++str2;
@@ -126,8 +702,13 @@ int strncmp(const char* str1, const char* str2, unsigned long n) {
 
 char* strncpy(char* dest, const char* src, size_t n) {
     char* ret = dest;
-    while (n-- && (*dest++ = *src++));
-    while (n--) *dest++ = '\0';
+    while (n && (*dest = *src)) {
+        dest++;
+        src++;
+        n--;
+    }
+    // the rest of the n bytes, terminator included, are NULs
+    memset(dest, 0, n);
     return ret;
 }
 
@@ -158,23 +739,47 @@ char* itoa(int value, char* str, int base) {
     return str;
 }
 
-char* strtok(char* str, const char* delim) {
-    static char* next = NULL;
-    if (str) next = str;
+char* strtok_r(char* str, const char* delim, char** saveptr) {
+    char* next = str ? str : *saveptr;
     if (!next) return NULL;
 
-    while (*next && strchr(delim, *next)) next++;
-    if (!*next) return NULL;
+    next += strspn(next, delim);
+    if (!*next) {
+        *saveptr = NULL;
+        return NULL;
+    }
 
     char* start = next;
-
-    while (*next && !strchr(delim, *next)) next++;
+    next += strcspn(next, delim);
     if (*next) {
-        *next = '\0';
-        next++;
+        *next++ = '\0';
     } else {
         next = NULL;
     }
 
+    *saveptr = next;
     return start;
 }
+
+// not reentrant; new code should use strtok_r or str_next_token
+char* strtok(char* str, const char* delim) {
+    static char* next = NULL;
+    return strtok_r(str, delim, &next);
+}
+
+int str_next_token(const char** cursor, const char* delim, str_span_t* token) {
+    const char* p = *cursor + strspn(*cursor, delim);
+    if (!*p) {
+        *cursor = p;
+        return 0;
+    }
+
+    token->start = p;
+    token->length = strcspn(p, delim);
+    *cursor = p + token->length;
+    return 1;
+}
+
+int str_span_equals(str_span_t span, const char* str) {
+    return strncmp(span.start, str, span.length) == 0 && str[span.length] == '\0';
+}
@@ -5,7 +5,15 @@
 
 void* memset(void* ptr, int value, size_t num);
 void* memcpy(void* dest, const void* src, size_t num);
+void* memmove(void* dest, const void* src, size_t num);
 int memcmp(const void* ptr1, const void* ptr2, size_t num);
+void* memchr(const void* ptr, int value, size_t num);
+
+// CPU features string_init() can use; call it once at boot
+#define STRING_FEATURE_VECTOR 0x1   // RVV 1.0
+#define STRING_FEATURE_ZBB    0x2   // basic bit manipulation
+void string_init(unsigned int features);
+const char* string_impl_name(void);
 
 size_t strlen(const char* str);
 int strcmp(const char* str1, const char* str2);
@@ -15,13 +23,39 @@ char* strncpy(char* dest, const char* src, size_t n);  // Added this critical fu
 char* strcat(char* dest, const char* src);
 char* strncat(char* dest, const char* src, size_t n);
 char* strstr(const char* haystack, const char* needle);
+void* memmem(const void* haystack, size_t haystack_len, const void* needle, size_t needle_len);
 char* strchr(const char* str, int c);
 char* strrchr(const char* str, int c);
 char* strtok(char* str, const char* delim);
-
-char* strtok(char* str, const char* delim);
+char* strtok_r(char* str, const char* delim, char** saveptr);
 size_t strspn(const char* str1, const char* str2);
 size_t strcspn(const char* str1, const char* str2);
 
+// a needle preprocessed once and then run over many texts (every line or
+// file of a grep); the needle must stay valid while the search is in use
+typedef struct {
+    const unsigned char* needle;
+    size_t length;
+    size_t split;               // critical factorisation point
+    size_t period;
+    size_t memory;              // prefix kept after a period shift, 0 if aperiodic
+    unsigned char skip[256];    // Horspool shift for the last window byte
+} str_search_t;
+
+void str_search_init(str_search_t* search, const void* needle, size_t length);
+void* str_search_find(const str_search_t* search, const void* text, size_t length);
+
+// tokenizing without touching the source: a token is a pointer and length
+// into the original string and is not NUL-terminated
+typedef struct {
+    const char* start;
+    size_t length;
+} str_span_t;
+
+// finds the next token at *cursor and moves *cursor past it; 0 when the
+// string has no more tokens
+int str_next_token(const char** cursor, const char* delim, str_span_t* token);
+int str_span_equals(str_span_t span, const char* str);
+
 char* itoa(int value, char* str, int base); 
 #endif 
@@ -0,0 +1,124 @@
+# RVV 1.0 string and memory routines, installed by string_init() when misa
+# reports the V extension. Byte elements with LMUL=8, so each strip covers
+# up to 8 * VLEN / 8 bytes. The string scans and memchr use fault-only-first
+# loads so they never fault past the terminating NUL or the matching byte.
+
+.section .text
+.global memcpy_rvv
+.global memset_rvv
+.global memcmp_rvv
+.global memchr_rvv
+.global strlen_rvv
+.global strchr_rvv
+
+# void* memcpy_rvv(void* dest, const void* src, size_t n)
+memcpy_rvv:
+    mv a3, a0
+1:
+    vsetvli t0, a2, e8, m8, ta, ma
+    vle8.v v8, (a1)
+    vse8.v v8, (a3)
+    add a1, a1, t0
+    add a3, a3, t0
+    sub a2, a2, t0
+    bnez a2, 1b
+    ret
+
+# void* memset_rvv(void* ptr, int value, size_t n)
+memset_rvv:
+    mv a3, a0
+    vsetvli t0, a2, e8, m8, ta, ma
+    vmv.v.x v8, a1
+1:
+    vsetvli t0, a2, e8, m8, ta, ma
+    vse8.v v8, (a3)
+    add a3, a3, t0
+    sub a2, a2, t0
+    bnez a2, 1b
+    ret
+
+# int memcmp_rvv(const void* a, const void* b, size_t n)
+memcmp_rvv:
+1:
+    vsetvli t0, a2, e8, m8, ta, ma
+    beqz t0, 3f
+    vle8.v v8, (a0)
+    vle8.v v16, (a1)
+    vmsne.vv v0, v8, v16
+    vfirst.m t1, v0
+    bgez t1, 2f
+    add a0, a0, t0
+    add a1, a1, t0
+    sub a2, a2, t0
+    j 1b
+2:
+    add a0, a0, t1
+    add a1, a1, t1
+    lbu t2, 0(a0)
+    lbu t3, 0(a1)
+    sub a0, t2, t3
+    ret
+3:
+    li a0, 0
+    ret
+
+# void* memchr_rvv(const void* ptr, int value, size_t n): n may run past the
+# end of the object as long as the byte is found before it
+memchr_rvv:
+    andi a1, a1, 0xff
+1:
+    vsetvli t0, a2, e8, m8, ta, ma
+    beqz t0, 3f
+    vle8ff.v v8, (a0)
+    csrr t0, vl
+    vmseq.vx v0, v8, a1
+    vfirst.m t1, v0
+    bgez t1, 2f
+    add a0, a0, t0
+    sub a2, a2, t0
+    j 1b
+2:
+    add a0, a0, t1
+    ret
+3:
+    li a0, 0
+    ret
+
+# size_t strlen_rvv(const char* str)
+strlen_rvv:
+    mv a3, a0
+1:
+    vsetvli a1, x0, e8, m8, ta, ma
+    vle8ff.v v8, (a3)
+    csrr a1, vl
+    vmseq.vi v0, v8, 0
+    vfirst.m a2, v0
+    add a3, a3, a1
+    bltz a2, 1b
+    sub a3, a3, a1
+    add a3, a3, a2
+    sub a0, a3, a0
+    ret
+
+# char* strchr_rvv(const char* str, int c): stops at c or the NUL, whichever
+# comes first, and returns NULL only if it was the NUL and c is not 0
+strchr_rvv:
+    andi a1, a1, 0xff
+1:
+    vsetvli t0, x0, e8, m8, ta, ma
+    vle8ff.v v8, (a0)
+    csrr t0, vl
+    vmseq.vx v0, v8, a1
+    vmseq.vi v16, v8, 0
+    vmor.mm v0, v0, v16
+    vfirst.m t1, v0
+    bgez t1, 2f
+    add a0, a0, t0
+    j 1b
+2:
+    add a0, a0, t1
+    lbu t2, 0(a0)
+    beq t2, a1, 3f
+    li a0, 0
+3:
+    ret
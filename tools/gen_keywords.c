@@ -0,0 +1,157 @@
+// build-time generator for the editor/shell keyword tables: reads word
+// lists (whitespace separated, # comments) and writes a header with one
+// collision-free hash table per list, named keywords_<list basename>.
+//
+// usage: gen_keywords <output.h> <list.txt>...
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../kernel/editor/keyword_hash.h"
+
+#define MAX_WORDS 255     // slots hold a byte index
+#define MAX_WORD 32
+#define MAX_SLOTS 65536
+#define MAX_SEED 1000000u
+
+typedef struct {
+    char name[64];
+    char words[MAX_WORDS][MAX_WORD];
+    unsigned int count;
+    unsigned int seed;
+    unsigned int size;
+} word_list_t;
+
+static int load_list(const char* path, word_list_t* list) {
+    FILE* file = fopen(path, "r");
+    if (!file) {
+        perror(path);
+        return -1;
+    }
+
+    // table name from the file name without directory or extension
+    const char* base = strrchr(path, '/');
+    base = base ? base + 1 : path;
+    size_t len = strcspn(base, ".");
+    if (len >= sizeof(list->name)) {
+        len = sizeof(list->name) - 1;
+    }
+    memcpy(list->name, base, len);
+    list->name[len] = '\0';
+
+    char line[256];
+    list->count = 0;
+    while (fgets(line, sizeof(line), file)) {
+        char* hash = strchr(line, '#');
+        if (hash) {
+            *hash = '\0';
+        }
+        for (char* word = strtok(line, " \t\r\n"); word; word = strtok(NULL, " \t\r\n")) {
+            if (strlen(word) >= MAX_WORD || list->count == MAX_WORDS) {
+                fprintf(stderr, "%s: word '%s' too long or too many words\n", path, word);
+                fclose(file);
+                return -1;
+            }
+            for (unsigned int i = 0; i < list->count; i++) {
+                if (strcmp(list->words[i], word) == 0) {
+                    fprintf(stderr, "%s: duplicate word '%s'\n", path, word);
+                    fclose(file);
+                    return -1;
+                }
+            }
+            strcpy(list->words[list->count++], word);
+        }
+    }
+
+    fclose(file);
+    return 0;
+}
+
+// smallest power-of-two table (starting at 2x the word count) for which
+// some seed maps every word to its own slot
+static int find_seed(word_list_t* list) {
+    static unsigned char used[MAX_SLOTS];
+
+    for (list->size = 2; list->size < 2 * list->count; list->size *= 2) {
+    }
+
+    for (; list->size <= MAX_SLOTS; list->size *= 2) {
+        for (unsigned int seed = 0; seed < MAX_SEED; seed++) {
+            unsigned int i;
+            memset(used, 0, list->size);
+            for (i = 0; i < list->count; i++) {
+                unsigned int slot = keyword_hash(list->words[i], seed) & (list->size - 1);
+                if (used[slot]) {
+                    break;
+                }
+                used[slot] = 1;
+            }
+            if (i == list->count) {
+                list->seed = seed;
+                return 0;
+            }
+        }
+    }
+    return -1;
+}
+
+static void write_table(FILE* out, const word_list_t* list) {
+    fprintf(out, "static const char* const keywords_%s_words[%u] = {\n",
+            list->name, list->count);
+    for (unsigned int i = 0; i < list->count; i++) {
+        fprintf(out, "    \"%s\",\n", list->words[i]);
+    }
+    fprintf(out, "};\n\n");
+
+    fprintf(out, "static const unsigned char keywords_%s_slots[%u] = {\n",
+            list->name, list->size);
+    for (unsigned int i = 0; i < list->count; i++) {
+        unsigned int slot = keyword_hash(list->words[i], list->seed) & (list->size - 1);
+        fprintf(out, "    [%u] = %u,\n", slot, i + 1);
+    }
+    fprintf(out, "};\n\n");
+
+    fprintf(out, "static const keyword_table_t keywords_%s = {\n", list->name);
+    fprintf(out, "    keywords_%s_words, keywords_%s_slots, %uu, %uu\n};\n\n",
+            list->name, list->name, list->seed, list->size - 1);
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        fprintf(stderr, "usage: %s <output.h> <list.txt>...\n", argv[0]);
+        return 1;
+    }
+
+    static word_list_t list;
+    FILE* out = fopen(argv[1], "w");
+    if (!out) {
+        perror(argv[1]);
+        return 1;
+    }
+
+    fprintf(out, "// generated by tools/gen_keywords, do not edit\n");
+    fprintf(out, "#ifndef KEYWORDS_GEN_H\n#define KEYWORDS_GEN_H\n\n");
+    fprintf(out, "#include \"keyword_hash.h\"\n\n");
+
+    for (int i = 2; i < argc; i++) {
+        if (load_list(argv[i], &list) != 0) {
+            goto fail;
+        }
+        if (find_seed(&list) != 0) {
+            fprintf(stderr, "%s: no perfect hash found\n", argv[i]);
+            goto fail;
+        }
+        fprintf(out, "// %s: %u words in %u slots\n", argv[i], list.count, list.size);
+        write_table(out, &list);
+    }
+
+    fprintf(out, "#endif\n");
+    fclose(out);
+    return 0;
+
+fail:
+    fclose(out);
+    remove(argv[1]);
+    return 1;
+}
@@ -0,0 +1,275 @@
+// host-side replay of a kmalloc trace captured with `ktrace` on a KTRACE=1
+// kernel. kernel/memory/memory.c is compiled natively and driven with the
+// recorded calls, so allocator changes can be timed on the build machine.
+//
+// usage: kmalloc_replay <uart-log> [passes] [-v]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define PAGE_SIZE 4096UL
+#define PAGE_MAX_ORDER 14
+#define PAGE_MAX_FRAMES ((128UL * 1024 * 1024) / PAGE_SIZE)
+#define DEFAULT_PASSES 100
+
+// kernel allocator API (kernel/memory/memory.h can't be mixed with libc headers)
+void memory_init(void);
+void* kmalloc(size_t size);
+void* kcalloc(size_t count, size_t size);
+void* krealloc(void* ptr, size_t size);
+void* kmalloc_aligned(size_t size, size_t align);
+void kfree(void* ptr);
+void memory_print_info(void);
+void memory_print_details(void);
+
+typedef struct {
+    char op;
+    unsigned long id;
+    unsigned long size;
+    unsigned long align;
+} trace_event_t;
+
+static int verbose = 0;
+
+// kernel services used by memory.c
+void console_putchar(char c) {
+    if (verbose) {
+        putchar(c);
+    }
+}
+
+void console_puts(const char* str) {
+    if (verbose) {
+        fputs(str, stdout);
+    }
+}
+
+void console_println(const char* str) {
+    if (verbose) {
+        puts(str);
+    }
+}
+
+void console_put_hex(unsigned long value) {
+    if (verbose) {
+        printf((value >> 32) ? "0x%016lX" : "0x%08lX", value);
+    }
+}
+
+void kernel_panic(const char* message) {
+    fprintf(stderr, "kernel panic: %s\n", message);
+    abort();
+}
+
+// the heap finds page-backed arenas by frame number, so the stub page
+// allocator hands out naturally aligned blocks from one fixed pool. Freed
+// blocks go on a per-order list and are never merged; a replay is short
+static char* page_pool = NULL;
+static size_t page_pool_used = 0;
+static void* page_free_list[PAGE_MAX_ORDER + 1];
+
+void* alloc_pages(unsigned int order) {
+    size_t size = PAGE_SIZE << order;
+    if (page_free_list[order]) {
+        void* block = page_free_list[order];
+        page_free_list[order] = *(void**)block;
+        return block;
+    }
+    if (!page_pool) {
+        page_pool = aligned_alloc(PAGE_SIZE << PAGE_MAX_ORDER, PAGE_MAX_FRAMES * PAGE_SIZE);
+        if (!page_pool) {
+            return NULL;
+        }
+    }
+    size_t offset = (page_pool_used + size - 1) & ~(size - 1);
+    if (offset + size > PAGE_MAX_FRAMES * PAGE_SIZE) {
+        return NULL;
+    }
+    page_pool_used = offset + size;
+    return page_pool + offset;
+}
+
+void free_pages(void* addr, unsigned int order) {
+    *(void**)addr = page_free_list[order];
+    page_free_list[order] = addr;
+}
+
+size_t page_frame_number(const void* addr) {
+    if (!page_pool || (const char*)addr < page_pool ||
+        (const char*)addr >= page_pool + PAGE_MAX_FRAMES * PAGE_SIZE) {
+        return PAGE_MAX_FRAMES;
+    }
+    return (size_t)((const char*)addr - page_pool) / PAGE_SIZE;
+}
+
+unsigned int page_order_for_size(size_t size) {
+    unsigned int order = 0;
+    while (order < PAGE_MAX_ORDER && (PAGE_SIZE << order) < size) {
+        order++;
+    }
+    return order;
+}
+
+// collect the events between "ktrace begin" and "ktrace end"; anything else
+// in the log (prompts, other command output) is ignored
+static trace_event_t* load_trace(const char* path, size_t* count) {
+    FILE* file = fopen(path, "r");
+    if (!file) {
+        perror(path);
+        return NULL;
+    }
+
+    size_t capacity = 1024;
+    trace_event_t* events = malloc(capacity * sizeof(trace_event_t));
+    char line[256];
+    int inside = 0;
+
+    *count = 0;
+    while (events && fgets(line, sizeof(line), file)) {
+        if (strncmp(line, "ktrace begin", 12) == 0) {
+            inside = 1;
+            *count = 0;
+            continue;
+        }
+        if (strncmp(line, "ktrace end", 10) == 0) {
+            inside = 0;
+            continue;
+        }
+        if (!inside) {
+            continue;
+        }
+
+        trace_event_t event;
+        unsigned long delta;
+        if (sscanf(line, "%c %li %li %li %li", &event.op, &event.id,
+                   &event.size, &event.align, &delta) != 5) {
+            continue;
+        }
+
+        if (*count == capacity) {
+            capacity *= 2;
+            events = realloc(events, capacity * sizeof(trace_event_t));
+            if (!events) {
+                break;
+            }
+        }
+        events[(*count)++] = event;
+    }
+
+    fclose(file);
+    if (!events) {
+        fprintf(stderr, "out of memory\n");
+    }
+    return events;
+}
+
+// one pass over the trace; ids whose allocation fell out of the ring buffer
+// are skipped. Everything still live at the end is freed so the next pass
+// starts from the same heap.
+static void replay(const trace_event_t* events, size_t count, void** live,
+                   unsigned long min_id, size_t num_ids, int report) {
+    for (size_t i = 0; i < count; i++) {
+        const trace_event_t* event = &events[i];
+        void** slot = &live[event->id - min_id];
+
+        switch (event->op) {
+            case 'A':
+                *slot = (event->align > 8) ? kmalloc_aligned(event->size, event->align)
+                                           : kmalloc(event->size);
+                break;
+            case 'C':
+                *slot = kcalloc(1, event->size);
+                break;
+            case 'R':
+                if (*slot) {
+                    *slot = krealloc(*slot, event->size);
+                }
+                break;
+            case 'F':
+                kfree(*slot);
+                *slot = NULL;
+                break;
+        }
+    }
+
+    if (report) {
+        memory_print_info();
+        memory_print_details();
+    }
+
+    for (size_t i = 0; i < num_ids; i++) {
+        kfree(live[i]);
+        live[i] = NULL;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    const char* path = NULL;
+    long passes = DEFAULT_PASSES;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-v") == 0) {
+            verbose = 1;
+        } else if (!path) {
+            path = argv[i];
+        } else {
+            passes = strtol(argv[i], NULL, 0);
+        }
+    }
+
+    if (!path || passes <= 0) {
+        fprintf(stderr, "usage: %s <uart-log> [passes] [-v]\n", argv[0]);
+        return 1;
+    }
+
+    size_t count;
+    trace_event_t* events = load_trace(path, &count);
+    if (!events) {
+        return 1;
+    }
+    if (count == 0) {
+        fprintf(stderr, "%s: no ktrace events found\n", path);
+        return 1;
+    }
+
+    unsigned long min_id = events[0].id;
+    unsigned long max_id = events[0].id;
+    for (size_t i = 1; i < count; i++) {
+        if (events[i].id < min_id) {
+            min_id = events[i].id;
+        }
+        if (events[i].id > max_id) {
+            max_id = events[i].id;
+        }
+    }
+
+    size_t num_ids = max_id - min_id + 1;
+    void** live = calloc(num_ids, sizeof(void*));
+    if (!live) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+
+    memory_init();
+
+    // the first pass warms the heap and prints the allocator state if asked
+    replay(events, count, live, min_id, num_ids, verbose);
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (long pass = 0; pass < passes; pass++) {
+        replay(events, count, live, min_id, num_ids, 0);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    double elapsed_ns = (end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec);
+    printf("events: %zu, passes: %ld\n", count, passes);
+    printf("total: %.3f ms, %.1f ns/event\n", elapsed_ns / 1e6,
+           elapsed_ns / ((double)count * passes));
+
+    free(live);
+    free(events);
+    return 0;
+}
@@ -0,0 +1,494 @@
+// host-side benchmark for lib/string.c. The kernel's string.c is compiled
+// natively with every symbol renamed to k_* (objcopy --prefix-symbols), so
+// it can be linked next to glibc and each routine compared against the
+// libc one: first for correctness over small sizes, every alignment pair
+// and random inputs, then for speed from 1 byte to 1 MB at every
+// alignment offset. Only the portable word-at-a-time code runs here; the
+// Zbb and RVV variants need the kernel.
+//
+// usage: string_bench [-c] [-q] [function...]
+//   -c  correctness check only    -q  fewer sizes
+
+#define _GNU_SOURCE     // memmem
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+#define MAX_SIZE (1 << 20)
+#define PAD 128                       // room for offsets, NULs and strcat
+#define CHECK_MAX_SIZE 600
+#define CHECK_ROUNDS 4
+#define ALIGNMENTS 8
+#define BENCH_BYTES (1 << 20)         // per measurement
+#define BENCH_MIN_CALLS 4
+#define SEARCH_CHAR 0xAA
+#define NEEDLE_MAX 16
+
+// lib/string.c, renamed
+void* k_memset(void* ptr, int value, size_t num);
+void* k_memcpy(void* dest, const void* src, size_t num);
+void* k_memmove(void* dest, const void* src, size_t num);
+int k_memcmp(const void* ptr1, const void* ptr2, size_t num);
+void* k_memchr(const void* ptr, int value, size_t num);
+size_t k_strlen(const char* str);
+int k_strcmp(const char* str1, const char* str2);
+int k_strncmp(const char* str1, const char* str2, size_t n);
+char* k_strcpy(char* dest, const char* src);
+char* k_strncpy(char* dest, const char* src, size_t n);
+char* k_strcat(char* dest, const char* src);
+char* k_strncat(char* dest, const char* src, size_t n);
+char* k_strstr(const char* haystack, const char* needle);
+void* k_memmem(const void* haystack, size_t haystack_len, const void* needle, size_t needle_len);
+char* k_strchr(const char* str, int c);
+char* k_strrchr(const char* str, int c);
+size_t k_strspn(const char* str1, const char* str2);
+size_t k_strcspn(const char* str1, const char* str2);
+
+enum { KERNEL, GLIBC };
+
+// per-call parameters chosen by prepare(); check mode randomizes them,
+// bench mode picks the case that scans the whole buffer
+typedef struct {
+    char* src;
+    char* dst;
+    size_t size;
+    size_t n;               // strncmp/strncpy/strncat limit, needle length
+    size_t prefix;          // strcat: length of the string already in dst
+    int value;
+} call_t;
+
+typedef struct {
+    const char* name;
+    int two_buffers;        // dst alignment matters too
+    void (*prepare)(call_t* call, int checking);
+    // result relative to the buffers (offsets, -1 for NULL, sign of compares)
+    long (*run)(int impl, call_t* call);
+} string_func_t;
+
+static char* src_buf;
+static char* dst_buf;
+
+static long ptr_result(const void* result, const void* base) {
+    return result ? (const char*)result - (const char*)base : -1;
+}
+
+static long sign(int value) {
+    return (value > 0) - (value < 0);
+}
+
+static int chance(int percent) {
+    return rand() % 100 < percent;
+}
+
+// random bytes that are never NUL or SEARCH_CHAR
+static void fill_string(char* p, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        unsigned char c = rand() % 255 + 1;
+        p[i] = (c == SEARCH_CHAR) ? c + 1 : c;
+    }
+    p[length] = '\0';
+}
+
+static void fill_alphabet(char* p, size_t length, const char* alphabet) {
+    size_t letters = strlen(alphabet);
+    for (size_t i = 0; i < length; i++) {
+        p[i] = alphabet[rand() % letters];
+    }
+    p[length] = '\0';
+}
+
+static void prepare_memset(call_t* call, int checking) {
+    call->value = checking ? rand() : 0x5a;
+}
+
+static long run_memset(int impl, call_t* call) {
+    void* result = (impl == KERNEL ? k_memset : memset)(call->dst, call->value, call->size);
+    return ptr_result(result, call->dst);
+}
+
+static void prepare_memcpy(call_t* call, int checking) {
+    (void)checking;
+    fill_string(call->src, call->size);
+}
+
+static long run_memcpy(int impl, call_t* call) {
+    void* result = (impl == KERNEL ? k_memcpy : memcpy)(call->dst, call->src, call->size);
+    return ptr_result(result, call->dst);
+}
+
+// overlapping, inside src_buf; dst above src forces a backward copy
+static void prepare_memmove(call_t* call, int checking) {
+    fill_string(call->src, call->size + PAD / 2);
+    call->dst = call->src + (call->dst - dst_buf) + 1;
+    if (checking && chance(50)) {
+        char* tmp = call->dst;
+        call->dst = call->src;
+        call->src = tmp;
+    }
+}
+
+static long run_memmove(int impl, call_t* call) {
+    void* result = (impl == KERNEL ? k_memmove : memmove)(call->dst, call->src, call->size);
+    return ptr_result(result, call->dst);
+}
+
+// equal buffers, or one differing byte
+static void prepare_compare(call_t* call, int checking) {
+    fill_string(call->src, call->size);
+    memcpy(call->dst, call->src, call->size + 1);
+    if (checking && call->size && chance(70)) {
+        size_t at = rand() % call->size;
+        call->dst[at] = chance(20) ? '\0' : (char)rand();
+    }
+    call->n = (checking && chance(50)) ? rand() % (call->size + 8) : call->size;
+}
+
+static long run_memcmp(int impl, call_t* call) {
+    return sign((impl == KERNEL ? k_memcmp : memcmp)(call->src, call->dst, call->size));
+}
+
+static long run_strcmp(int impl, call_t* call) {
+    return sign((impl == KERNEL ? k_strcmp : strcmp)(call->src, call->dst));
+}
+
+static long run_strncmp(int impl, call_t* call) {
+    return sign((impl == KERNEL ? k_strncmp : strncmp)(call->src, call->dst, call->n));
+}
+
+// SEARCH_CHAR nowhere (bench), or at a few random places
+static void prepare_search_char(call_t* call, int checking) {
+    fill_string(call->src, call->size);
+    call->value = SEARCH_CHAR;
+    if (!checking) {
+        return;
+    }
+    int hits = call->size ? rand() % 3 : 0;
+    for (int i = 0; i < hits; i++) {
+        call->src[rand() % call->size] = (char)SEARCH_CHAR;
+    }
+    if (chance(10)) {
+        call->value = chance(50) ? 0 : SEARCH_CHAR | 0x100;   // NUL; high bits ignored
+    }
+}
+
+static long run_memchr(int impl, call_t* call) {
+    return ptr_result((impl == KERNEL ? k_memchr : memchr)(call->src, call->value, call->size), call->src);
+}
+
+static long run_strlen(int impl, call_t* call) {
+    return (long)(impl == KERNEL ? k_strlen : strlen)(call->src);
+}
+
+static long run_strchr(int impl, call_t* call) {
+    return ptr_result((impl == KERNEL ? k_strchr : strchr)(call->src, call->value), call->src);
+}
+
+// strrchr has to scan everything anyway; put the one hit at the front
+static void prepare_strrchr(call_t* call, int checking) {
+    prepare_search_char(call, checking);
+    if (!checking && call->size) {
+        call->src[0] = (char)SEARCH_CHAR;
+    }
+}
+
+static long run_strrchr(int impl, call_t* call) {
+    return ptr_result((impl == KERNEL ? k_strrchr : strrchr)(call->src, call->value), call->src);
+}
+
+static void prepare_strcpy(call_t* call, int checking) {
+    size_t length = call->size;
+    if (checking && chance(30)) {
+        length = rand() % (call->size + 1);
+    }
+    fill_string(call->src, length);
+    call->n = call->size + (checking ? rand() % 16 : 0);
+    call->prefix = checking ? rand() % 16 : 0;
+    fill_string(call->dst, call->prefix);
+}
+
+static long run_strcpy(int impl, call_t* call) {
+    return ptr_result((impl == KERNEL ? k_strcpy : strcpy)(call->dst, call->src), call->dst);
+}
+
+static long run_strncpy(int impl, call_t* call) {
+    return ptr_result((impl == KERNEL ? k_strncpy : strncpy)(call->dst, call->src, call->n), call->dst);
+}
+
+// resetting the terminator keeps repeated bench calls appending to the same prefix
+static long run_strcat(int impl, call_t* call) {
+    call->dst[call->prefix] = '\0';
+    return ptr_result((impl == KERNEL ? k_strcat : strcat)(call->dst, call->src), call->dst);
+}
+
+static long run_strncat(int impl, call_t* call) {
+    call->dst[call->prefix] = '\0';
+    return ptr_result((impl == KERNEL ? k_strncat : strncat)(call->dst, call->src, call->n), call->dst);
+}
+
+// small alphabet so partial matches are common; the bench needle only
+// occurs at the very end
+static void prepare_substring(call_t* call, int checking) {
+    fill_alphabet(call->src, call->size, checking ? "ab" : "abcd");
+    if (checking) {
+        call->n = rand() % (NEEDLE_MAX / 2 + 1);
+        if (call->size && chance(50)) {
+            size_t at = rand() % call->size;
+            if (call->n > call->size - at) {
+                call->n = call->size - at;
+            }
+            memcpy(call->dst, call->src + at, call->n);
+        } else {
+            fill_alphabet(call->dst, call->n, "ab");
+        }
+    } else {
+        call->n = call->size < NEEDLE_MAX ? call->size : NEEDLE_MAX;
+        if (call->n) {
+            call->src[call->size - call->n] = 'e';
+        }
+        memcpy(call->dst, call->src + call->size - call->n, call->n);
+    }
+    call->dst[call->n] = '\0';
+}
+
+static long run_strstr(int impl, call_t* call) {
+    return ptr_result((impl == KERNEL ? k_strstr : strstr)(call->src, call->dst), call->src);
+}
+
+static long run_memmem(int impl, call_t* call) {
+    return ptr_result((impl == KERNEL ? k_memmem : memmem)(call->src, call->size, call->dst, call->n),
+                      call->src);
+}
+
+static void prepare_span(call_t* call, int checking) {
+    fill_alphabet(call->src, call->size, "abcdefgh");
+    if (checking && call->size && chance(70)) {
+        call->src[rand() % call->size] = 'x';
+    }
+}
+
+static long run_strspn(int impl, call_t* call) {
+    return (long)(impl == KERNEL ? k_strspn : strspn)(call->src, "abcdefgh");
+}
+
+static long run_strcspn(int impl, call_t* call) {
+    return (long)(impl == KERNEL ? k_strcspn : strcspn)(call->src, "xyz");
+}
+
+static const string_func_t funcs[] = {
+    { "memset",  1, prepare_memset,      run_memset },
+    { "memcpy",  1, prepare_memcpy,      run_memcpy },
+    { "memmove", 1, prepare_memmove,     run_memmove },
+    { "memcmp",  1, prepare_compare,     run_memcmp },
+    { "memchr",  0, prepare_search_char, run_memchr },
+    { "strlen",  0, prepare_search_char, run_strlen },
+    { "strcmp",  1, prepare_compare,     run_strcmp },
+    { "strncmp", 1, prepare_compare,     run_strncmp },
+    { "strchr",  0, prepare_search_char, run_strchr },
+    { "strrchr", 0, prepare_strrchr,     run_strrchr },
+    { "strcpy",  1, prepare_strcpy,      run_strcpy },
+    { "strncpy", 1, prepare_strcpy,      run_strncpy },
+    { "strcat",  1, prepare_strcpy,      run_strcat },
+    { "strncat", 1, prepare_strcpy,      run_strncat },
+    { "strstr",  1, prepare_substring,   run_strstr },
+    { "memmem",  1, prepare_substring,   run_memmem },
+    { "strspn",  0, prepare_span,        run_strspn },
+    { "strcspn", 0, prepare_span,        run_strcspn },
+};
+
+#define NUM_FUNCS (sizeof(funcs) / sizeof(funcs[0]))
+
+static void setup_call(call_t* call, size_t size, size_t src_off, size_t dst_off) {
+    call->src = src_buf + src_off;
+    call->dst = dst_buf + dst_off;
+    call->size = size;
+    call->n = size;
+    call->prefix = 0;
+    call->value = 0;
+}
+
+// runs both implementations on identical inputs and compares the result
+// and everything they may have written
+static int check_one(const string_func_t* f, size_t size, size_t src_off, size_t dst_off) {
+    static char src_copy[2 * CHECK_MAX_SIZE + 2 * PAD];
+    static char dst_copy[2 * CHECK_MAX_SIZE + 2 * PAD];
+    size_t span = sizeof(src_copy);
+    unsigned int seed = rand();
+    long result[2];
+
+    for (int impl = KERNEL; impl <= GLIBC; impl++) {
+        memset(src_buf, 0x11, span);
+        memset(dst_buf, 0x22, span);
+        srand(seed);
+
+        call_t call;
+        setup_call(&call, size, src_off, dst_off);
+        f->prepare(&call, 1);
+        result[impl] = f->run(impl, &call);
+
+        if (impl == KERNEL) {
+            memcpy(src_copy, src_buf, span);
+            memcpy(dst_copy, dst_buf, span);
+        }
+    }
+
+    if (result[KERNEL] != result[GLIBC] ||
+        memcmp(src_copy, src_buf, span) != 0 || memcmp(dst_copy, dst_buf, span) != 0) {
+        fprintf(stderr, "%s: mismatch at size %zu, src+%zu dst+%zu (seed %u): kernel %ld, glibc %ld%s\n",
+                f->name, size, src_off, dst_off, seed, result[KERNEL], result[GLIBC],
+                result[KERNEL] == result[GLIBC] ? " (buffers differ)" : "");
+        return 1;
+    }
+    return 0;
+}
+
+static int check(const string_func_t* f) {
+    int failures = 0;
+    for (int round = 0; round < CHECK_ROUNDS; round++) {
+        for (size_t size = 0; size <= CHECK_MAX_SIZE; size += (size < 80) ? 1 : 1 + rand() % 37) {
+            for (size_t src_off = 0; src_off < ALIGNMENTS; src_off++) {
+                for (size_t dst_off = 0; dst_off < (f->two_buffers ? ALIGNMENTS : 1); dst_off++) {
+                    failures += check_one(f, size, src_off, dst_off);
+                    if (failures > 10) {
+                        return failures;
+                    }
+                }
+            }
+        }
+    }
+    return failures;
+}
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static volatile long sink;
+
+static double time_calls(const string_func_t* f, int impl, call_t* call, long calls) {
+    long acc = 0;
+    double start = now_ns();
+    for (long i = 0; i < calls; i++) {
+        acc += f->run(impl, call);
+    }
+    double elapsed = now_ns() - start;
+    sink += acc;
+    return elapsed / calls;
+}
+
+// mean ns/call over every alignment pair, plus the slowest pair for the kernel
+static void bench(const string_func_t* f, const size_t* sizes, int num_sizes) {
+    printf("\n%s\n", f->name);
+    printf("%10s %12s %12s %11s %11s %8s %16s\n",
+           "size", "kernel ns", "glibc ns", "kernel GB/s", "glibc GB/s", "k/glibc", "worst src,dst");
+
+    for (int s = 0; s < num_sizes; s++) {
+        size_t size = sizes[s];
+        long calls = BENCH_BYTES / size;
+        if (calls < BENCH_MIN_CALLS) {
+            calls = BENCH_MIN_CALLS;
+        }
+
+        double total[2] = { 0, 0 };
+        double worst = 0;
+        size_t worst_src = 0, worst_dst = 0;
+        int pairs = 0;
+
+        for (size_t src_off = 0; src_off < ALIGNMENTS; src_off++) {
+            for (size_t dst_off = 0; dst_off < (f->two_buffers ? ALIGNMENTS : 1); dst_off++) {
+                call_t call;
+                setup_call(&call, size, src_off, dst_off);
+                f->prepare(&call, 0);
+
+                for (int impl = KERNEL; impl <= GLIBC; impl++) {
+                    double ns = time_calls(f, impl, &call, calls);
+                    total[impl] += ns;
+                    if (impl == KERNEL && ns > worst) {
+                        worst = ns;
+                        worst_src = src_off;
+                        worst_dst = dst_off;
+                    }
+                }
+                pairs++;
+            }
+        }
+
+        double kernel_ns = total[KERNEL] / pairs;
+        double glibc_ns = total[GLIBC] / pairs;
+        char worst_text[32];
+        snprintf(worst_text, sizeof(worst_text), "+%zu,+%zu", worst_src, worst_dst);
+        printf("%10zu %12.1f %12.1f %11.2f %11.2f %8.2f %16s\n",
+               size, kernel_ns, glibc_ns, size / kernel_ns, size / glibc_ns,
+               kernel_ns / glibc_ns, worst_text);
+    }
+}
+
+static int selected(const char* name, int argc, char* argv[], int first) {
+    if (first >= argc) {
+        return 1;
+    }
+    for (int i = first; i < argc; i++) {
+        if (strcmp(argv[i], name) == 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    static const size_t full_sizes[] = {
+        1, 2, 3, 4, 7, 8, 15, 16, 31, 32, 63, 64, 128, 256, 512,
+        1 << 10, 4 << 10, 16 << 10, 64 << 10, 256 << 10, 1 << 20
+    };
+    static const size_t quick_sizes[] = { 1, 8, 64, 512, 4 << 10, 64 << 10, 1 << 20 };
+    int check_only = 0;
+    int quick = 0;
+    int first = 1;
+
+    for (; first < argc && argv[first][0] == '-'; first++) {
+        if (strcmp(argv[first], "-c") == 0) {
+            check_only = 1;
+        } else if (strcmp(argv[first], "-q") == 0) {
+            quick = 1;
+        } else {
+            fprintf(stderr, "usage: %s [-c] [-q] [function...]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    // dst sits right after src so overruns show up as changed bytes
+    src_buf = aligned_alloc(64, 2 * (MAX_SIZE + 2 * PAD));
+    if (!src_buf) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+    dst_buf = src_buf + MAX_SIZE + 2 * PAD;
+    srand(1);
+
+    int failures = 0;
+    for (size_t i = 0; i < NUM_FUNCS; i++) {
+        if (!selected(funcs[i].name, argc, argv, first)) {
+            continue;
+        }
+        int failed = check(&funcs[i]);
+        printf("check %-8s %s\n", funcs[i].name, failed ? "FAILED" : "ok");
+        failures += failed;
+    }
+
+    if (!check_only) {
+        const size_t* sizes = quick ? quick_sizes : full_sizes;
+        int num_sizes = quick ? sizeof(quick_sizes) / sizeof(quick_sizes[0])
+                              : sizeof(full_sizes) / sizeof(full_sizes[0]);
+        for (size_t i = 0; i < NUM_FUNCS; i++) {
+            if (selected(funcs[i].name, argc, argv, first)) {
+                bench(&funcs[i], sizes, num_sizes);
+            }
+        }
+    }
+
+    free(src_buf);
+    return failures ? 1 : 0;
+}